@@ -0,0 +1,47 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bench {
+    inline double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // run fn once and return the elapsed time in seconds
+    template <typename F>
+    double time(F&& fn) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        return seconds_since(start);
+    }
+
+    // keep the compiler from discarding a computed value
+    template <typename T>
+    void keep(const T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    inline std::vector<double> random_doubles(size_t n, unsigned seed = 42) {
+        std::mt19937_64 gen(seed);
+        std::uniform_real_distribution<double> dist(0.0, 1e6);
+        std::vector<double> keys(n);
+        for (auto& key : keys) {
+            key = dist(gen);
+        }
+        return keys;
+    }
+
+    // number of keys from the first command line argument, or the given default
+    inline size_t arg_size(int argc, char const* argv[], size_t fallback) {
+        return argc > 1 ? std::strtoull(argv[1], nullptr, 10) : fallback;
+    }
+
+    inline void report(const char* name, size_t ops, double secs) {
+        std::printf("%-32s %10.2f Mops/s %10.1f ns/op\n", name, ops / secs / 1e6, secs * 1e9 / ops);
+    }
+}
@@ -0,0 +1,72 @@
+// heap bytes per entry held by a BPlusTree<double, double>
+// g++ -std=c++17 -O2 -I../include/Trees bplus_memory.cpp -o bplus_memory && ./bplus_memory 1000000
+#include <malloc.h>
+#include <new>
+#include "bench.hpp"
+#include "b_plus_tree.hpp"
+
+static size_t live_bytes = 0;
+
+void* operator new(size_t size) {
+    void* p = std::malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    live_bytes += malloc_usable_size(p);
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (p != nullptr) {
+        live_bytes -= malloc_usable_size(p);
+        std::free(p);
+    }
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    size_t align = static_cast<size_t>(alignment);
+    void* p = std::aligned_alloc(align, (size + align - 1) / align * align);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    live_bytes += malloc_usable_size(p);
+    return p;
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    operator delete(p);
+}
+
+template <typename Tree>
+void run(const char* name, const std::vector<double>& keys, Tree* tree) {
+    size_t before = live_bytes;
+    double secs = bench::time([&] {
+        for (double key : keys) {
+            tree->insert(key, key);
+        }
+    });
+    size_t bytes = live_bytes - before;
+    std::printf("%-42s %8.1f bytes/entry %8.1f ns/insert\n", name, double(bytes) / keys.size(), secs * 1e9 / keys.size());
+    delete tree;
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 1000000);
+    auto keys = bench::random_doubles(n);
+    std::printf("n = %zu\n", n);
+
+    run("BPlusTree<double, double>(16)", keys, new BPlusTree<double, double>(16));
+    run("BPlusTree<double, double, 16>", keys, new BPlusTree<double, double, 16>());
+    run("BPlusTree<double, double, 16, NodePool>", keys, new BPlusTree<double, double, 16, NodePool>());
+    run("BPlusTree<int, int, 16>", keys, new BPlusTree<int, int, 16>());
+    run("BPlusTree<int, int, 16, NodePool>", keys, new BPlusTree<int, int, 16, NodePool>());
+    return 0;
+}
@@ -0,0 +1,36 @@
+// range scans over BPlusTree covering 1%, 10% and 100% of the keys
+// g++ -std=c++17 -O2 -I../include/Trees bplus_range.cpp -o bplus_range && ./bplus_range 1000000
+#include "bench.hpp"
+#include "b_plus_tree.hpp"
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 1000000);
+    auto keys = bench::random_doubles(n);
+
+    BPlusTree<double, double, 16> tree;
+    for (double key : keys) {
+        tree.insert(key, key);
+    }
+
+    std::printf("n = %zu, MinDegree = 16\n", n);
+    std::mt19937_64 gen(7);
+    for (double selectivity : {0.01, 0.1, 1.0}) {
+        // keys are uniform in [0, 1e6), so a range of width selectivity * 1e6 holds that share of the keys
+        double width = selectivity * 1e6;
+        std::uniform_real_distribution<double> start(0.0, 1e6 - width);
+        int scans = selectivity < 1.0 ? 20 : 5;
+
+        size_t entries = 0;
+        double secs = bench::time([&] {
+            for (int i = 0; i < scans; i++) {
+                double lower_bound = start(gen);
+                entries += tree.range_search(lower_bound, lower_bound + width).size();
+            }
+        });
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "range %5.1f%%", selectivity * 100);
+        std::printf("%-16s %10.2f ms/scan %10.1f ns/entry\n", name, secs * 1e3 / scans, secs * 1e9 / entries);
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+// point lookup latency of BPlusTree with double keys
+// g++ -std=c++17 -O2 -I../include/Trees bplus_search.cpp -o bplus_search && ./bplus_search 1000000
+#include "bench.hpp"
+#include "b_plus_tree.hpp"
+
+template <typename Tree>
+void run(const char* name, Tree& tree, std::vector<double> keys) {
+    for (double key : keys) {
+        tree.insert(key, key);
+    }
+
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(7));
+    double sum = 0;
+    double secs = bench::time([&] {
+        for (double key : keys) {
+            sum += tree.search(key);
+        }
+    });
+    bench::keep(sum);
+    bench::report(name, keys.size(), secs);
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 1000000);
+    auto keys = bench::random_doubles(n);
+    std::printf("n = %zu, point lookups\n", n);
+
+    {
+        BPlusTree<double, double> tree(16);
+        run("BPlusTree<double, double>(16)", tree, keys);
+    }
+    {
+        BPlusTree<double, double, 16> tree;
+        run("BPlusTree<double, double, 16>", tree, keys);
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+// full in-order scans of a BTree of double keys: the stack-based iterator from begin() to end(),
+// range_search() over every key with a visitor and range_search() returning a vector of copies
+// g++ -std=c++17 -O2 -I../include/Trees btree_iterator.cpp -o btree_iterator && ./btree_iterator 10000000
+#include <limits>
+#include "bench.hpp"
+#include "b_tree.hpp"
+
+int main(int argc, char const* argv[]) {
+    size_t max_n = bench::arg_size(argc, argv, 10000000);
+    const double lowest = -std::numeric_limits<double>::infinity();
+    const double highest = std::numeric_limits<double>::infinity();
+
+    std::printf("%12s %14s %14s %14s\n", "n", "iterator ns", "visitor ns", "vector ns");
+    for (size_t n = 10000; n <= max_n; n *= 10) {
+        auto keys = bench::random_doubles(n);
+        BTree<double, double, 16> tree;
+        for (double key : keys) {
+            tree.insert(key, key);
+        }
+
+        double sum = 0;
+        double iterator_secs = bench::time([&] {
+            for (auto it = tree.begin(); it != tree.end(); ++it) {
+                sum += it.value();
+            }
+        });
+
+        double visitor_secs = bench::time([&] {
+            tree.range_search(lowest, highest, [&](const double&, const double& value) {
+                sum += value;
+            });
+        });
+
+        double vector_secs = bench::time([&] {
+            for (const auto& entry : tree.range_search(lowest, highest)) {
+                sum += entry.second;
+            }
+        });
+        bench::keep(sum);
+
+        std::printf("%12zu %14.2f %14.2f %14.2f\n", n, iterator_secs * 1e9 / n, visitor_secs * 1e9 / n,
+            vector_secs * 1e9 / n);
+    }
+    return 0;
+}
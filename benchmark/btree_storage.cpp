@@ -0,0 +1,43 @@
+// insert and lookup throughput of BTree with double keys, runtime vs compile-time min degree
+// g++ -std=c++17 -O2 -I../include/Trees btree_storage.cpp -o btree_storage && ./btree_storage 10000000
+#include "bench.hpp"
+#include "b_tree.hpp"
+
+template <typename Tree>
+void run(const char* name, Tree& tree, std::vector<double> keys) {
+    size_t n = keys.size();
+    double insert_secs = bench::time([&] {
+        for (size_t i = 0; i < n; i++) {
+            tree.insert(keys[i], keys[i]);
+        }
+    });
+
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(7));
+    double sum = 0;
+    double search_secs = bench::time([&] {
+        for (size_t i = 0; i < n; i++) {
+            sum += tree.search(keys[i]);
+        }
+    });
+    bench::keep(sum);
+
+    std::printf("%s\n", name);
+    bench::report("  insert", n, insert_secs);
+    bench::report("  search", n, search_secs);
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 10000000);
+    auto keys = bench::random_doubles(n);
+    std::printf("n = %zu, min_degree = 16\n", n);
+
+    {
+        BTree<double, double> tree(16);
+        run("BTree<double, double>(16)", tree, keys);
+    }
+    {
+        BTree<double, double, 16> tree;
+        run("BTree<double, double, 16>", tree, keys);
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+// comparisons per lookup for composite (tenant, id) keys and string keys: key types with only operator<,
+// where a lookup compares twice at the key it stops on, against the same keys with operator<=>, where
+// one three-way comparison per probed key also tells whether the key was found
+// g++ -std=c++20 -O2 -I../include/Trees compare_count.cpp -o compare_count && ./compare_count 1000000
+#include <compare>
+#include "bench.hpp"
+#include "b_tree.hpp"
+#include "b_plus_tree.hpp"
+
+static size_t comparisons = 0;
+
+template <bool ThreeWay>
+struct Account {
+    std::string tenant;
+    long id;
+
+    friend bool operator<(const Account& a, const Account& b) requires (!ThreeWay) {
+        comparisons++;
+        return a.tenant < b.tenant || (!(b.tenant < a.tenant) && a.id < b.id);
+    }
+
+    friend std::strong_ordering operator<=>(const Account& a, const Account& b) requires ThreeWay {
+        comparisons++;
+        if (auto order = a.tenant.compare(b.tenant); order != 0) {
+            return order <=> 0;
+        }
+        return a.id <=> b.id;
+    }
+
+    friend bool operator==(const Account& a, const Account& b) {
+        comparisons++;
+        return a.tenant == b.tenant && a.id == b.id;
+    }
+};
+
+template <bool ThreeWay>
+struct Name {
+    std::string text;
+
+    friend bool operator<(const Name& a, const Name& b) requires (!ThreeWay) {
+        comparisons++;
+        return a.text < b.text;
+    }
+
+    friend std::strong_ordering operator<=>(const Name& a, const Name& b) requires ThreeWay {
+        comparisons++;
+        return a.text.compare(b.text) <=> 0;
+    }
+
+    friend bool operator==(const Name& a, const Name& b) {
+        comparisons++;
+        return a.text == b.text;
+    }
+};
+
+template <typename Tree, typename Key>
+void run(const char* name, int degree, const std::vector<Key>& keys) {
+    Tree tree(degree);
+    for (const Key& key : keys) {
+        tree.insert(key, 1);
+    }
+
+    auto probes = keys;
+    std::shuffle(probes.begin(), probes.end(), std::mt19937_64(7));
+
+    long sum = 0;
+    comparisons = 0;
+    double secs = bench::time([&] {
+        for (const Key& key : probes) {
+            sum += *tree.find(key);
+        }
+    });
+    bench::keep(sum);
+    std::printf("  %-34s degree %3d %8.2f comparisons/lookup %10.1f ns/lookup\n", name, degree,
+        double(comparisons) / probes.size(), secs * 1e9 / probes.size());
+}
+
+template <template <bool> typename Key>
+void run_all(const char* name, const std::vector<Key<false>>& less_keys, const std::vector<Key<true>>& three_way_keys) {
+    std::printf("%s\n", name);
+    for (int degree : {16, 128}) {
+        run<BPlusTree<Key<false>, int>>("BPlusTree, operator<", degree, less_keys);
+        run<BPlusTree<Key<true>, int>>("BPlusTree, operator<=>", degree, three_way_keys);
+        run<BTree<Key<false>, int>>("BTree, operator<", degree, less_keys);
+        run<BTree<Key<true>, int>>("BTree, operator<=>", degree, three_way_keys);
+    }
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 1000000);
+
+    // few tenants with long names, so most comparisons go through a long common prefix
+    std::vector<Account<false>> less_accounts;
+    std::vector<Account<true>> three_way_accounts;
+    std::vector<Name<false>> less_names;
+    std::vector<Name<true>> three_way_names;
+    std::mt19937_64 gen(42);
+    for (size_t i = 0; i < n; i++) {
+        char tenant[48];
+        std::snprintf(tenant, sizeof(tenant), "tenant-%03llu.production", static_cast<unsigned long long>(gen() % 100));
+        long id = static_cast<long>(i);
+        less_accounts.push_back({tenant, id});
+        three_way_accounts.push_back({tenant, id});
+
+        char text[32];
+        std::snprintf(text, sizeof(text), "TXN-%020llu", static_cast<unsigned long long>(gen()));
+        less_names.push_back({text});
+        three_way_names.push_back({text});
+    }
+    std::printf("n = %zu, lookups of existing keys\n", n);
+
+    run_all<Account>("Account {tenant, id}", less_accounts, three_way_accounts);
+    run_all<Name>("Name {std::string}", less_names, three_way_names);
+    return 0;
+}
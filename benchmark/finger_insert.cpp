@@ -0,0 +1,68 @@
+// BPlusTree inserts of sorted, nearly sorted and random key streams, and lookups in insertion order and
+// in random order, with the leaf finger and without it (built with -DTREES_NO_FINGER); lookups in
+// insertion order also with enable_finger_lookups()
+// g++ -std=c++17 -O2 -I../include/Trees finger_insert.cpp -o finger_insert && ./finger_insert 4000000
+// g++ -std=c++17 -O2 -DTREES_NO_FINGER -I../include/Trees finger_insert.cpp -o finger_insert && ./finger_insert 4000000
+#include "bench.hpp"
+#include "b_plus_tree.hpp"
+
+template <typename Tree>
+void run(const char* name, const std::vector<double>& keys) {
+    Tree tree(16);
+    double secs = bench::time([&] {
+        for (double key : keys) {
+            tree.insert(key, key);
+        }
+    });
+    std::printf("%s\n", name);
+    bench::report("  insert", keys.size(), secs);
+
+    double sum = 0;
+    for (bool finger_lookups : {false, true}) {
+        tree.enable_finger_lookups(finger_lookups);
+        secs = bench::time([&] {
+            for (double key : keys) {
+                sum += *tree.find(key);
+            }
+        });
+        bench::report(finger_lookups ? "  find in order, finger lookups" : "  find in insertion order",
+            keys.size(), secs);
+    }
+    tree.enable_finger_lookups(false);
+
+    auto probes = keys;
+    std::shuffle(probes.begin(), probes.end(), std::mt19937_64(7));
+    secs = bench::time([&] {
+        for (double key : probes) {
+            sum += *tree.find(key);
+        }
+    });
+    bench::report("  find in random order", keys.size(), secs);
+    bench::keep(sum);
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 4000000);
+
+    auto random = bench::random_doubles(n);
+    auto sorted = random;
+    std::sort(sorted.begin(), sorted.end());
+
+    // time-ordered events that arrive slightly late: every key moves back by up to 64 positions
+    auto nearly_sorted = sorted;
+    std::mt19937_64 gen(42);
+    for (size_t i = 1; i < n; i++) {
+        size_t back = std::min<size_t>(i, gen() % 64);
+        std::swap(nearly_sorted[i], nearly_sorted[i - back]);
+    }
+
+#if defined(TREES_NO_FINGER)
+    std::printf("n = %zu, without the leaf finger\n", n);
+#else
+    std::printf("n = %zu, with the leaf finger\n", n);
+#endif
+    run<BPlusTree<double, double, 16>>("sorted", sorted);
+    run<BPlusTree<double, double, 16>>("nearly sorted", nearly_sorted);
+    run<BPlusTree<double, double, 16>>("random", random);
+    return 0;
+}
@@ -0,0 +1,101 @@
+// mixed workload over transaction ids, 95% exact-match lookups and 5% range scans of about 50 keys,
+// on a BPlusTree with and without the hash index, and the heap memory of the tree and of the index
+// g++ -std=c++17 -O2 -I../include/Trees hash_index.cpp -o hash_index && ./hash_index 2000000
+#include <malloc.h>
+#include <new>
+#include "bench.hpp"
+#include "b_plus_tree.hpp"
+
+static size_t live_bytes = 0;
+
+void* operator new(size_t size) {
+    void* p = std::malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    live_bytes += malloc_usable_size(p);
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (p != nullptr) {
+        live_bytes -= malloc_usable_size(p);
+        std::free(p);
+    }
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+using Tree = BPlusTree<std::string, int, 16>;
+
+struct Operation {
+    size_t key;  // index into the sorted keys
+    bool range;  // scan [key, key + 50) instead of a lookup
+};
+
+void run(const char* name, bool hash_index, const std::vector<std::string>& keys, const std::vector<std::string>& sorted,
+         const std::vector<Operation>& operations) {
+    size_t before = live_bytes;
+    auto tree = new Tree(16);
+    if (hash_index) {
+        tree->enable_hash_index();
+    }
+    double insert_secs = bench::time([&] {
+        for (const std::string& key : keys) {
+            tree->insert(key, 1);
+        }
+    });
+    size_t tree_bytes = live_bytes - before;
+
+    long sum = 0;
+    size_t lookups = 0;
+    double lookup_secs = 0;
+    double scan_secs = 0;
+    for (const Operation& operation : operations) {
+        if (operation.range) {
+            scan_secs += bench::time([&] {
+                sum += tree->range_search(sorted[operation.key], sorted[operation.key + 49]).size();
+            });
+        } else {
+            lookup_secs += bench::time([&] {
+                sum += *tree->find(sorted[operation.key]);
+            });
+            lookups++;
+        }
+    }
+    bench::keep(sum);
+
+    HashIndexStats stats = tree->hash_index_stats();
+    std::printf("%-18s insert %7.1f ns  lookup %7.1f ns  scan %8.1f ns  total %6.3f s  "
+                "tree %7.1f MB  hash index %6.1f MB (%4.1f bytes/key)\n",
+        name, insert_secs * 1e9 / keys.size(), lookup_secs * 1e9 / lookups, scan_secs * 1e9 / (operations.size() - lookups),
+        lookup_secs + scan_secs, (tree_bytes - stats.bytes) / 1e6, stats.bytes / 1e6, double(stats.bytes) / keys.size());
+    delete tree;
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 2000000);
+
+    std::vector<std::string> keys;
+    std::mt19937_64 gen(42);
+    for (size_t i = 0; i < n; i++) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "TXN-%020llu", static_cast<unsigned long long>(gen()));
+        keys.emplace_back(buffer);
+    }
+    auto sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<Operation> operations(n);
+    std::uniform_int_distribution<size_t> position(0, n - 50);
+    for (auto& operation : operations) {
+        operation = Operation{position(gen), gen() % 20 == 0};
+    }
+
+    std::printf("n = %zu, 95%% exact lookups, 5%% range scans of 50 keys\n", n);
+    run("tree only", false, keys, sorted, operations);
+    run("with hash index", true, keys, sorted, operations);
+    return 0;
+}
@@ -0,0 +1,67 @@
+// ingestion of the transactions dataset scaled to n rows, with the default allocator and with an arena
+// g++ -std=c++17 -O2 -I../include -I../include/Trees ingest.cpp -o ingest && ./ingest 2000000
+#include <fstream>
+#include "bench.hpp"
+#include "b_tree.hpp"
+#include "b_plus_tree.hpp"
+#include "json.hpp"
+
+using Row = std::pair<double, std::pair<std::string, std::string>>;
+
+// replicate the transactions n times over, jittering the amounts so that keys stay spread out
+std::vector<Row> load_rows(const char* file_path, size_t n) {
+    std::ifstream input_file(file_path);
+    nlohmann::json json_data;
+    input_file >> json_data;
+
+    std::vector<Row> base;
+    for (const auto& person : json_data.items()) {
+        for (const auto& transaction : person.value()) {
+            base.push_back({transaction["Amount"], {person.key(), transaction["TransactionID"]}});
+        }
+    }
+
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> jitter(0.5, 1.5);
+    std::vector<Row> rows;
+    rows.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        const Row& row = base[i % base.size()];
+        rows.push_back({row.first * jitter(gen), {row.second.first, row.second.second + "-" + std::to_string(i)}});
+    }
+    return rows;
+}
+
+// Indexed = true stores the row number instead of the row, so the nodes are trivially destructible
+template <typename Tree, bool Indexed = false>
+void run(const char* name, const std::vector<Row>& rows) {
+    auto tree = new Tree(16);
+    double insert_secs = bench::time([&] {
+        for (size_t i = 0; i < rows.size(); i++) {
+            if constexpr (Indexed) {
+                tree->insert(rows[i].first, i);
+            } else {
+                tree->insert(rows[i].first, rows[i].second);
+            }
+        }
+    });
+    double destroy_secs = bench::time([&] { delete tree; });
+    std::printf("%-36s insert %8.1f ns/row   destroy %8.1f ms\n", name, insert_secs * 1e9 / rows.size(), destroy_secs * 1e3);
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 2000000);
+    auto rows = load_rows("../data/transactions.json", n);
+    std::printf("n = %zu rows, min_degree = 16\n", n);
+
+    using Value = std::pair<std::string, std::string>;
+    run<BTree<double, Value, 16>>("BTree std::allocator", rows);
+    run<BTree<double, Value, 16, ArenaAllocator<char>>>("BTree ArenaAllocator", rows);
+    run<BPlusTree<double, Value, 16>>("BPlusTree std::allocator", rows);
+    run<BPlusTree<double, Value, 16, ArenaAllocator<char>>>("BPlusTree ArenaAllocator", rows);
+    run<BTree<double, size_t, 16>, true>("BTree row index std::allocator", rows);
+    run<BTree<double, size_t, 16, ArenaAllocator<char>>, true>("BTree row index ArenaAllocator", rows);
+    run<BPlusTree<double, size_t, 16>, true>("BPlusTree row index std::allocator", rows);
+    run<BPlusTree<double, size_t, 16, ArenaAllocator<char>>, true>("BPlusTree row index ArenaAllocator", rows);
+    return 0;
+}
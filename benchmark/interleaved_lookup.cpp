@@ -0,0 +1,58 @@
+// coroutine-interleaved lookups (InterleavedLookup) against one find() per key and the hand-written
+// group prefetching of multi_search, on trees larger than the last level cache
+// g++ -std=c++20 -O2 -I../include/Trees interleaved_lookup.cpp -o interleaved_lookup && ./interleaved_lookup 40000000
+#include "bench.hpp"
+#include "b_tree.hpp"
+#include "b_plus_tree.hpp"
+#include "interleaved_lookup.hpp"
+
+template <typename Tree>
+void run(const char* name, const std::vector<double>& keys) {
+    Tree tree(16);
+    for (double key : keys) {
+        tree.insert(key, key);
+    }
+
+    std::vector<double> probes(keys.begin(), keys.begin() + std::min<size_t>(keys.size(), 2000000));
+    std::shuffle(probes.begin(), probes.end(), std::mt19937_64(7));
+    std::vector<double*> results(probes.size());
+    std::printf("%s\n", name);
+
+    double sum = 0;
+    double secs = bench::time([&] {
+        for (double key : probes) {
+            sum += *tree.find(key);
+        }
+    });
+    bench::report("  find", probes.size(), secs);
+
+    secs = bench::time([&] {
+        tree.multi_search(probes.data(), probes.size(), results.data());
+    });
+    bench::report("  multi_search", probes.size(), secs);
+
+    for (size_t width : {4, 8, 16, 32}) {
+        InterleavedLookup<Tree> engine(tree, width);
+        secs = bench::time([&] {
+            engine.run(probes.data(), probes.size(), results.data());
+        });
+        char label[64];
+        std::snprintf(label, sizeof(label), "  InterleavedLookup width %zu", width);
+        bench::report(label, probes.size(), secs);
+    }
+
+    for (double* value : results) {
+        sum += *value;
+    }
+    bench::keep(sum);
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 40000000);
+    auto keys = bench::random_doubles(n);
+    std::printf("n = %zu, lookups of existing keys\n", n);
+
+    run<BPlusTree<double, double, 16>>("BPlusTree<double, double, 16>", keys);
+    run<BTree<double, double, 16>>("BTree<double, double, 16>", keys);
+    return 0;
+}
@@ -0,0 +1,73 @@
+// BPlusTree lookups of transaction ids where 90% of the probes are absent, without the key filter
+// and with it at several bits per key, next to the filter's memory and false positive rate
+// g++ -std=c++17 -O2 -I../include/Trees key_filter.cpp -o key_filter && ./key_filter 2000000
+#include "bench.hpp"
+#include "b_plus_tree.hpp"
+
+using Tree = BPlusTree<std::string, int, 16>;
+
+std::string transaction_id(std::mt19937_64& gen) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "TXN-%020llu", static_cast<unsigned long long>(gen()));
+    return buffer;
+}
+
+void run(const char* name, int bits_per_key, const std::vector<std::string>& keys,
+         const std::vector<std::string>& probes, const std::vector<std::string>& absent) {
+    Tree tree(16);
+    if (bits_per_key > 0) {
+        tree.enable_filter(bits_per_key);
+    }
+    double insert_secs = bench::time([&] {
+        for (const std::string& key : keys) {
+            tree.insert(key, 1);
+        }
+    });
+
+    long hits = 0;
+    double secs = bench::time([&] {
+        for (const std::string& key : probes) {
+            hits += tree.contains(key);
+        }
+    });
+    bench::keep(hits);
+
+    size_t passed = 0;
+    for (const std::string& key : absent) {
+        passed += tree.may_contain(key);
+    }
+
+    FilterStats stats = tree.filter_stats();
+    std::printf("%-22s insert %7.1f ns  lookup %7.1f ns  filter %6.2f MB %5.1f bits/key  "
+                "false positives %6.3f%% expected %6.3f%% measured\n",
+        name, insert_secs * 1e9 / keys.size(), secs * 1e9 / probes.size(), stats.bytes / 1e6, stats.bits_per_key,
+        100 * stats.false_positive_rate, 100.0 * passed / absent.size());
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 2000000);
+
+    std::mt19937_64 gen(42);
+    std::vector<std::string> keys(n);
+    for (auto& key : keys) {
+        key = transaction_id(gen);
+    }
+    std::vector<std::string> absent(n);
+    for (auto& key : absent) {
+        key = transaction_id(gen);
+    }
+
+    // one present key for every nine absent ones
+    std::vector<std::string> probes;
+    for (size_t i = 0; i < n; i++) {
+        probes.push_back(i % 10 == 0 ? keys[i] : absent[i]);
+    }
+    std::shuffle(probes.begin(), probes.end(), std::mt19937_64(7));
+
+    std::printf("n = %zu, 90%% of the lookups miss\n", n);
+    run("no filter", 0, keys, probes, absent);
+    run("filter, 6 bits/key", 6, keys, probes, absent);
+    run("filter, 10 bits/key", 10, keys, probes, absent);
+    run("filter, 16 bits/key", 16, keys, probes, absent);
+    return 0;
+}
@@ -0,0 +1,89 @@
+// BPlusTree lookups of double keys through the internal nodes and through the learned index at several
+// error bounds, with the memory of each index, then again after 10% more keys patch the leaf chain
+// g++ -std=c++17 -O2 -I../include/Trees learned_index.cpp -o learned_index && ./learned_index 10000000
+#include "bench.hpp"
+#include "b_plus_tree.hpp"
+
+using Tree = BPlusTree<double, double, 16>;
+
+void measure(const char* name, Tree& tree, const std::vector<double>& probes) {
+    double sum = 0;
+    double secs = bench::time([&] {
+        for (double key : probes) {
+            sum += *tree.find(key);
+        }
+    });
+    bench::keep(sum);
+    bench::report(name, probes.size(), secs);
+}
+
+void report_memory(Tree& tree) {
+    LearnedIndexStats stats = tree.learned_index_stats();
+    std::printf("  %zu leaves, %zu segments, %.2f MB model, %.2f MB internal nodes, %zu leaf splits since the build\n",
+        stats.leaves, stats.segments, stats.bytes / 1e6, stats.internal_bytes / 1e6, stats.stale_splits);
+}
+
+// keys 0..n-1 inserted in order and indexed, then n / 20 more appended; lookups of the appended keys
+// through the internal nodes of a tree without the index and through the learned one
+void sorted_append(size_t n) {
+    size_t appended = n / 20;
+    Tree plain(16);
+    Tree tree(16);
+    for (size_t i = 0; i < n; i++) {
+        plain.insert(double(i), double(i));
+        tree.insert(double(i), double(i));
+    }
+    tree.build_learned_index(16);
+    for (size_t i = n; i < n + appended; i++) {
+        plain.insert(double(i), double(i));
+        tree.insert(double(i), double(i));
+    }
+
+    std::vector<double> probes(std::min<size_t>(appended, 2000000));
+    std::mt19937_64 gen(11);
+    std::uniform_int_distribution<size_t> appended_key(n, n + appended - 1);
+    for (double& key : probes) {
+        key = double(appended_key(gen));
+    }
+
+    std::printf("sorted, %zu keys appended after the build, lookups of those\n", appended);
+    measure("descent", plain, probes);
+    measure("learned, max_error 16", tree, probes);
+    report_memory(tree);
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 10000000);
+    auto keys = bench::random_doubles(n + n / 10);
+
+    Tree tree(16);
+    for (size_t i = 0; i < n; i++) {
+        tree.insert(keys[i], keys[i]);
+    }
+
+    std::vector<double> probes(keys.begin(), keys.begin() + std::min<size_t>(n, 2000000));
+    std::shuffle(probes.begin(), probes.end(), std::mt19937_64(7));
+
+    std::printf("n = %zu, lookups of existing keys\n", n);
+    measure("descent", tree, probes);
+    for (int max_error : {4, 16, 64}) {
+        tree.build_learned_index(max_error);
+        char label[64];
+        std::snprintf(label, sizeof(label), "learned, max_error %d", max_error);
+        measure(label, tree, probes);
+        report_memory(tree);
+    }
+
+    // the index built with max_error 64 stays in use: the new keys split leaves, which are
+    // reached through the chain until enough of them trigger a rebuild
+    for (size_t i = n; i < keys.size(); i++) {
+        tree.insert(keys[i], keys[i]);
+    }
+    std::printf("after %zu more inserts\n", keys.size() - n);
+    measure("learned, max_error 64", tree, probes);
+    report_memory(tree);
+
+    tree = Tree(16);
+    sorted_append(n);
+    return 0;
+}
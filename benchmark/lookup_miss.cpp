@@ -0,0 +1,69 @@
+// lookup latency of hits and misses: search() with try/catch against find() and contains()
+// g++ -std=c++17 -O2 -I../include/Trees lookup_miss.cpp -o lookup_miss && ./lookup_miss 1000000
+#include "bench.hpp"
+#include "b_tree.hpp"
+#include "b_plus_tree.hpp"
+
+template <typename Tree, typename Lookup>
+void measure(const char* name, Tree& tree, const std::vector<double>& probes, Lookup lookup) {
+    double sum = 0;
+    double secs = bench::time([&] {
+        for (double key : probes) {
+            sum += lookup(tree, key);
+        }
+    });
+    bench::keep(sum);
+    bench::report(name, probes.size(), secs);
+}
+
+template <typename Tree>
+void run(const char* name, const std::vector<double>& keys, const std::vector<double>& misses) {
+    Tree tree;
+    for (double key : keys) {
+        tree.insert(key, key);
+    }
+
+    auto hits = keys;
+    std::shuffle(hits.begin(), hits.end(), std::mt19937_64(7));
+    std::vector<double> throwing_misses(misses.begin(), misses.begin() + misses.size() / 100);
+
+    std::printf("%s\n", name);
+    auto search = [](Tree& tree, double key) {
+        try {
+            return tree.search(key);
+        } catch (const std::runtime_error&) {
+            return 0.0;
+        }
+    };
+    auto find = [](Tree& tree, double key) {
+        double* value = tree.find(key);
+        return value != nullptr ? *value : 0.0;
+    };
+    auto contains = [](Tree& tree, double key) {
+        return tree.contains(key) ? 1.0 : 0.0;
+    };
+
+    measure("  search hit", tree, hits, search);
+    measure("  search miss (1% of probes)", tree, throwing_misses, search);
+    measure("  find hit", tree, hits, find);
+    measure("  find miss", tree, misses, find);
+    measure("  contains hit", tree, hits, contains);
+    measure("  contains miss", tree, misses, contains);
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 1000000);
+    auto keys = bench::random_doubles(n);
+
+    // shifting every key by a small offset gives misses that land in the same leaves as the hits
+    auto misses = keys;
+    for (double& key : misses) {
+        key += 0.5e-3;
+    }
+    std::shuffle(misses.begin(), misses.end(), std::mt19937_64(11));
+
+    std::printf("n = %zu\n", n);
+    run<BTree<double, double, 16>>("BTree<double, double, 16>", keys, misses);
+    run<BPlusTree<double, double, 16>>("BPlusTree<double, double, 16>", keys, misses);
+    return 0;
+}
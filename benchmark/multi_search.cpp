@@ -0,0 +1,66 @@
+// batched lookups with multi_search against one find() per key, on trees larger than the last level cache
+// g++ -std=c++20 -O2 -I../include/Trees multi_search.cpp -o multi_search && ./multi_search 40000000
+#include <span>
+#include "bench.hpp"
+#include "b_tree.hpp"
+#include "b_plus_tree.hpp"
+
+template <typename Tree>
+void run(const char* name, const std::vector<double>& keys) {
+    Tree tree(16);
+    for (double key : keys) {
+        tree.insert(key, key);
+    }
+
+    std::vector<double> probes(keys.begin(), keys.begin() + std::min<size_t>(keys.size(), 2000000));
+    std::shuffle(probes.begin(), probes.end(), std::mt19937_64(7));
+    std::printf("%s\n", name);
+
+    double sum = 0;
+    double secs = bench::time([&] {
+        for (double key : probes) {
+            sum += *tree.find(key);
+        }
+    });
+    bench::report("  find", probes.size(), secs);
+
+    for (size_t batch : {16, 64, 256, 1024}) {
+        std::vector<double*> results(batch);
+        secs = bench::time([&] {
+            for (size_t first = 0; first < probes.size(); first += batch) {
+                size_t size = std::min(batch, probes.size() - first);
+                tree.multi_search(probes.data() + first, size, results.data());
+                for (size_t j = 0; j < size; j++) {
+                    sum += *results[j];
+                }
+            }
+        });
+        char label[64];
+        std::snprintf(label, sizeof(label), "  multi_search batch %zu", batch);
+        bench::report(label, probes.size(), secs);
+    }
+
+    // the span overload allocates its result vector per call
+    secs = bench::time([&] {
+        for (size_t first = 0; first < probes.size(); first += 256) {
+            size_t size = std::min<size_t>(256, probes.size() - first);
+            for (double* value : tree.multi_search(std::span<const double>(probes.data() + first, size))) {
+                sum += *value;
+            }
+        }
+    });
+    bench::report("  multi_search span 256", probes.size(), secs);
+    bench::keep(sum);
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 40000000);
+    auto keys = bench::random_doubles(n);
+    std::printf("n = %zu, lookups of existing keys\n", n);
+
+    run<BPlusTree<double, double, 16>>("BPlusTree<double, double, 16>", keys);
+    run<BTree<double, double, 16>>("BTree<double, double, 16>", keys);
+    run<BPlusTree<double, double, 16, NodePool>>("BPlusTree<double, double, 16, NodePool>", keys);
+    run<BPlusTree<double, double>>("BPlusTree<double, double>(16)", keys);
+    return 0;
+}
@@ -0,0 +1,59 @@
+// latency of narrow range scans (about 10 entries) over BPlusTree as the tree grows from 10^4 to
+// max_n keys, with an iterator from lower_bound() that stops at the first key past the range and with
+// range_search(), next to a find() of an existing key, which pays the same descent
+// g++ -std=c++17 -O2 -I../include/Trees narrow_range.cpp -o narrow_range && ./narrow_range 10000000
+#include "bench.hpp"
+#include "b_plus_tree.hpp"
+
+int main(int argc, char const* argv[]) {
+    size_t max_n = bench::arg_size(argc, argv, 10000000);
+    const size_t scans = 200000;
+    const double entries_per_scan = 10;
+
+    std::printf("%12s %16s %16s %12s %12s\n", "n", "iterator ns", "range_search ns", "find ns", "entries");
+    for (size_t n = 10000; n <= max_n; n *= 10) {
+        auto keys = bench::random_doubles(n);
+        BPlusTree<double, double, 16> tree;
+        for (double key : keys) {
+            tree.insert(key, key);
+        }
+
+        // keys are uniform in [0, 1e6), so a range of this width holds about entries_per_scan keys
+        double width = entries_per_scan * 1e6 / n;
+        std::mt19937_64 gen(7);
+        std::uniform_real_distribution<double> start(0.0, 1e6 - width);
+        std::vector<double> lower_bounds(scans);
+        for (double& lower_bound : lower_bounds) {
+            lower_bound = start(gen);
+        }
+
+        double sum = 0;
+        size_t entries = 0;
+        double iterator_secs = bench::time([&] {
+            for (double lower_bound : lower_bounds) {
+                double upper_bound = lower_bound + width;
+                for (auto it = tree.lower_bound(lower_bound); it != tree.end() && it.key() <= upper_bound; ++it) {
+                    sum += it.value();
+                    entries++;
+                }
+            }
+        });
+
+        double range_secs = bench::time([&] {
+            for (double lower_bound : lower_bounds) {
+                sum += tree.range_search(lower_bound, lower_bound + width).size();
+            }
+        });
+
+        double find_secs = bench::time([&] {
+            for (size_t i = 0; i < scans; i++) {
+                sum += *tree.find(keys[i % n]);
+            }
+        });
+        bench::keep(sum);
+
+        std::printf("%12zu %16.1f %16.1f %12.1f %12.1f\n", n, iterator_secs * 1e9 / scans, range_secs * 1e9 / scans,
+            find_secs * 1e9 / scans, double(entries) / scans);
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+// point lookups with double keys across min degrees 4..256
+// g++ -std=c++17 -O2 [-mavx2 | -DTREES_NO_SIMD] -I../include/Trees node_search.cpp -o node_search && ./node_search 1000000
+#include "bench.hpp"
+#include "b_tree.hpp"
+#include "b_plus_tree.hpp"
+
+template <typename Tree>
+double lookup_ns(const std::vector<double>& keys, const std::vector<double>& probes) {
+    Tree tree;
+    for (double key : keys) {
+        tree.insert(key, key);
+    }
+
+    double sum = 0;
+    double secs = bench::time([&] {
+        for (double key : probes) {
+            sum += tree.search(key);
+        }
+    });
+    bench::keep(sum);
+    return secs * 1e9 / probes.size();
+}
+
+template <int... Degrees>
+void run(const std::vector<double>& keys, const std::vector<double>& probes) {
+    std::printf("%8s %14s %14s\n", "degree", "BTree ns", "BPlusTree ns");
+    ((std::printf("%8d %14.1f %14.1f\n", Degrees,
+        lookup_ns<BTree<double, double, Degrees>>(keys, probes),
+        lookup_ns<BPlusTree<double, double, Degrees>>(keys, probes))), ...);
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 1000000);
+    auto keys = bench::random_doubles(n);
+    auto probes = keys;
+    std::shuffle(probes.begin(), probes.end(), std::mt19937_64(7));
+
+#if defined(TREES_NO_SIMD)
+    std::printf("n = %zu, scalar rank\n", n);
+#elif defined(__AVX2__)
+    std::printf("n = %zu, AVX2 rank\n", n);
+#else
+    std::printf("n = %zu, SSE rank\n", n);
+#endif
+    run<4, 8, 16, 32, 64, 128, 256>(keys, probes);
+    return 0;
+}
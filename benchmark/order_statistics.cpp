@@ -0,0 +1,80 @@
+// rank(), select() and count() with CountAggregate on BTree and BPlusTree, next to what they replace:
+// counting the entries of an iterator scan from begin() (rank, select) or from lower_bound() (count,
+// over ranges of about 1% of the keys); also the insert cost of keeping the counts
+// g++ -std=c++17 -O2 -I../include/Trees order_statistics.cpp -o order_statistics && ./order_statistics 1000000
+#include "bench.hpp"
+#include "b_tree.hpp"
+#include "b_plus_tree.hpp"
+
+template <typename Plain, typename Counted>
+void measure(const char* name, const std::vector<double>& keys) {
+    Plain plain;
+    Counted counted;
+    double plain_secs = bench::time([&] {
+        for (double key : keys) {
+            plain.insert(key, key);
+        }
+    });
+    double counted_secs = bench::time([&] {
+        for (double key : keys) {
+            counted.insert(key, key);
+        }
+    });
+
+    const size_t queries = 1000;
+    const size_t scans = 20;
+    size_t n = keys.size();
+    double width = 1e6 / 100;
+    size_t sum = 0;
+
+    double rank_secs = bench::time([&] {
+        for (size_t i = 0; i < queries; i++) {
+            sum += counted.rank(keys[i]);
+        }
+    });
+    double rank_scan_secs = bench::time([&] {
+        for (size_t i = 0; i < scans; i++) {
+            for (auto it = plain.begin(); it != plain.end() && it.key() < keys[i]; ++it) {
+                sum++;
+            }
+        }
+    });
+
+    double select_secs = bench::time([&] {
+        for (size_t i = 0; i < queries; i++) {
+            sum += counted.select(i * 7919 % n).key() > 0;
+        }
+    });
+
+    double count_secs = bench::time([&] {
+        for (size_t i = 0; i < queries; i++) {
+            sum += counted.count(keys[i], keys[i] + width);
+        }
+    });
+    double count_scan_secs = bench::time([&] {
+        for (size_t i = 0; i < scans; i++) {
+            for (auto it = plain.lower_bound(keys[i]); it != plain.end() && it.key() <= keys[i] + width; ++it) {
+                sum++;
+            }
+        }
+    });
+    bench::keep(sum);
+
+    std::printf("%-10s insert %6.1f -> %6.1f ns   rank %7.1f ns (scan %9.1f us)   select %7.1f ns   "
+                "count %7.1f ns (scan %7.1f us)\n",
+        name, plain_secs * 1e9 / n, counted_secs * 1e9 / n, rank_secs * 1e9 / queries, rank_scan_secs * 1e6 / scans,
+        select_secs * 1e9 / queries, count_secs * 1e9 / queries, count_scan_secs * 1e6 / scans);
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 1000000);
+    auto keys = bench::random_doubles(n);
+
+    using A = std::allocator<char>;
+    std::printf("n = %zu, insert without and with counts, queries with counts, scans without\n", n);
+    measure<BTree<double, double, 16>, BTree<double, double, 16, A, AdaptiveSearch, std::less<double>, CountAggregate>>(
+        "BTree", keys);
+    measure<BPlusTree<double, double, 16>,
+        BPlusTree<double, double, 16, A, AdaptiveSearch, std::less<double>, CountAggregate>>("BPlusTree", keys);
+    return 0;
+}
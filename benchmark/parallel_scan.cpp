@@ -0,0 +1,51 @@
+// a scan of 10M entries of a BPlusTree counting the values above a threshold, with range_search() and
+// with parallel_range_scan() on 1 to 16 threads, unordered and ordered; ordered, each worker keeps at
+// most 4 batches of 1024 recorded entries ahead of the calling thread, whatever the size of the range
+// g++ -std=c++17 -O2 -pthread -I../include/Trees parallel_scan.cpp -o parallel_scan && ./parallel_scan 10000000
+#include <atomic>
+#include "bench.hpp"
+#include "b_plus_tree.hpp"
+
+int main(int argc, char const* argv[]) {
+    size_t entries = bench::arg_size(argc, argv, 10000000);
+    size_t n = entries + entries / 5;
+    auto keys = bench::random_doubles(n);
+
+    BPlusTree<double, double, 16> tree;
+    for (double key : keys) {
+        tree.insert(key, key);
+    }
+
+    // keys are uniform in [0, 1e6), so this range holds about entries keys
+    double lower_bound = 1e5;
+    double upper_bound = lower_bound + double(entries) * 1e6 / n;
+    const double threshold = upper_bound - 1e6 / n * 1000;
+
+    // about 1000 matches, so the shared counter is rarely touched
+    std::atomic<size_t> matches{0};
+    auto count_matches = [&](const double&, const double& value) {
+        if (value > threshold) {
+            matches.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    std::printf("n = %zu, %u hardware threads, scans of about %zu entries\n", n, std::thread::hardware_concurrency(),
+        entries);
+    double serial_secs = bench::time([&] {
+        tree.range_search(lower_bound, upper_bound, count_matches);
+    });
+    std::printf("%-24s %8.1f ms\n", "range_search", serial_secs * 1e3);
+
+    for (unsigned threads : {1u, 2u, 4u, 8u, 16u}) {
+        double unordered_secs = bench::time([&] {
+            tree.parallel_range_scan(lower_bound, upper_bound, count_matches, threads);
+        });
+        double ordered_secs = bench::time([&] {
+            tree.parallel_range_scan(lower_bound, upper_bound, count_matches, threads, true);
+        });
+        std::printf("%2u threads  unordered %8.1f ms (%4.2fx)  ordered %8.1f ms (%4.2fx)\n", threads,
+            unordered_secs * 1e3, serial_secs / unordered_secs, ordered_secs * 1e3, serial_secs / ordered_secs);
+    }
+    bench::keep(matches.load());
+    return 0;
+}
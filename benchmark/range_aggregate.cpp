@@ -0,0 +1,76 @@
+// count and total of the values between two keys on BPlusTree: summing range_search(), summing in a
+// range_search() visitor, and range_aggregate() with SummaryAggregate, for ranges of r entries;
+// also the insert cost of keeping the summaries
+// g++ -std=c++17 -O2 -I../include/Trees range_aggregate.cpp -o range_aggregate && ./range_aggregate 1000000
+#include "bench.hpp"
+#include "b_plus_tree.hpp"
+
+using Plain = BPlusTree<double, double, 16>;
+using Aggregated = BPlusTree<double, double, 16, std::allocator<char>, AdaptiveSearch, std::less<double>,
+    SummaryAggregate<double>>;
+
+template <typename Tree>
+double build(Tree& tree, const std::vector<double>& keys) {
+    return bench::time([&] {
+        for (double key : keys) {
+            tree.insert(key, key / 100);
+        }
+    });
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 1000000);
+    const size_t queries = 1000;
+    auto keys = bench::random_doubles(n);
+
+    Plain plain;
+    Aggregated aggregated;
+    double plain_secs = build(plain, keys);
+    double aggregated_secs = build(aggregated, keys);
+    std::printf("n = %zu, insert %.1f ns without summaries, %.1f ns with\n", n, plain_secs * 1e9 / n,
+        aggregated_secs * 1e9 / n);
+
+    std::printf("%10s %16s %16s %16s\n", "r", "vector us", "visitor us", "aggregate us");
+    for (size_t range_size = 100; range_size <= n; range_size *= 10) {
+        // keys are uniform in [0, 1e6), so a range of this width holds about range_size keys
+        double width = double(range_size) * 1e6 / n;
+        std::mt19937_64 gen(7);
+        std::uniform_real_distribution<double> start(0.0, std::max(1e6 - width, 0.0));
+        std::vector<double> lower_bounds(queries);
+        for (double& lower_bound : lower_bounds) {
+            lower_bound = start(gen);
+        }
+
+        double total = 0;
+        double vector_secs = bench::time([&] {
+            for (double lower_bound : lower_bounds) {
+                for (const auto& entry : plain.range_search(lower_bound, lower_bound + width)) {
+                    total += entry.second;
+                }
+            }
+        });
+
+        double visitor_secs = bench::time([&] {
+            for (double lower_bound : lower_bounds) {
+                plain.range_search(lower_bound, lower_bound + width, [&](const double&, const double& value) {
+                    total += value;
+                });
+            }
+        });
+
+        size_t count = 0;
+        double aggregate_secs = bench::time([&] {
+            for (double lower_bound : lower_bounds) {
+                NumericSummary<double> summary = aggregated.range_aggregate(lower_bound, lower_bound + width);
+                total += summary.sum;
+                count += summary.count;
+            }
+        });
+        bench::keep(total);
+        bench::keep(count);
+
+        std::printf("%10zu %16.2f %16.2f %16.2f\n", range_size, vector_secs * 1e6 / queries,
+            visitor_secs * 1e6 / queries, aggregate_secs * 1e6 / queries);
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+// heap allocations and wall time of range scans returning 1M entries with std::string values, through
+// the range_search() that returns a vector of copies and through the visitor that receives references,
+// on BTree and BPlusTree; the last column stops the visitor after the first 1000 entries
+// g++ -std=c++17 -O2 -I../include/Trees range_visitor.cpp -o range_visitor && ./range_visitor 2000000
+#include <new>
+#include "bench.hpp"
+#include "b_tree.hpp"
+#include "b_plus_tree.hpp"
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = std::malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// scans of [lower_bound, lower_bound + entries) reporting allocations and ms per scan
+template <typename Tree>
+void measure(const char* name, Tree& tree, const std::vector<int>& lower_bounds, int entries) {
+    size_t sum = 0;
+    size_t before = allocations;
+    double vector_secs = bench::time([&] {
+        for (int lower_bound : lower_bounds) {
+            for (const auto& entry : tree.range_search(lower_bound, lower_bound + entries - 1)) {
+                sum += entry.second.size();
+            }
+        }
+    });
+    double vector_allocations = double(allocations - before) / lower_bounds.size();
+
+    before = allocations;
+    double visitor_secs = bench::time([&] {
+        for (int lower_bound : lower_bounds) {
+            tree.range_search(lower_bound, lower_bound + entries - 1, [&](const int&, const std::string& value) {
+                sum += value.size();
+            });
+        }
+    });
+    double visitor_allocations = double(allocations - before) / lower_bounds.size();
+
+    double stop_secs = bench::time([&] {
+        for (int lower_bound : lower_bounds) {
+            size_t seen = 0;
+            tree.range_search(lower_bound, lower_bound + entries - 1, [&](const int&, const std::string& value) {
+                sum += value.size();
+                return ++seen < 1000;
+            });
+        }
+    });
+    bench::keep(sum);
+
+    std::printf("%-10s vector %10.0f allocations %8.2f ms   visitor %4.0f allocations %8.2f ms   "
+                "stop at 1000 %8.3f ms\n",
+        name, vector_allocations, vector_secs * 1e3 / lower_bounds.size(), visitor_allocations,
+        visitor_secs * 1e3 / lower_bounds.size(), stop_secs * 1e3 / lower_bounds.size());
+}
+
+int main(int argc, char const* argv[]) {
+    int n = static_cast<int>(bench::arg_size(argc, argv, 2000000));
+    const int entries = std::min(n, 1000000);
+
+    // keys 0..n-1 in random order, values long enough to live on the heap
+    std::vector<int> keys(n);
+    for (int i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(42));
+
+    std::mt19937_64 gen(7);
+    std::uniform_int_distribution<int> start(0, n - entries);
+    std::vector<int> lower_bounds(10);
+    for (int& lower_bound : lower_bounds) {
+        lower_bound = start(gen);
+    }
+
+    std::printf("n = %d, scans of %d entries with std::string values\n", n, entries);
+    {
+        BTree<int, std::string, 16> tree;
+        for (int key : keys) {
+            tree.insert(key, "value of key " + std::to_string(key) + " in the tree");
+        }
+        measure("BTree", tree, lower_bounds, entries);
+    }
+    {
+        BPlusTree<int, std::string, 16> tree;
+        for (int key : keys) {
+            tree.insert(key, "value of key " + std::to_string(key) + " in the tree");
+        }
+        measure("BPlusTree", tree, lower_bounds, entries);
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+// "largest N first" queries over BPlusTree: the N largest keys of a range of about range_size entries,
+// by a forward range_search() of the whole range read from the back, and by reverse_range_search()
+// and a reverse_iterator, which stop after N entries
+// g++ -std=c++17 -O2 -I../include/Trees reverse_range.cpp -o reverse_range && ./reverse_range 1000000
+#include "bench.hpp"
+#include "b_plus_tree.hpp"
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 1000000);
+    const size_t queries = 2000;
+    const size_t top = 10;
+
+    auto keys = bench::random_doubles(n);
+    BPlusTree<double, double, 16> tree;
+    for (double key : keys) {
+        tree.insert(key, key);
+    }
+
+    std::printf("n = %zu, the %zu largest entries of ranges of r entries, us per query\n", n, top);
+    std::printf("%10s %16s %16s %16s\n", "r", "forward", "reverse visitor", "reverse iterator");
+    for (size_t range_size = 100; range_size <= n / 10; range_size *= 10) {
+        // keys are uniform in [0, 1e6), so a range of this width holds about range_size keys
+        double width = double(range_size) * 1e6 / n;
+        std::mt19937_64 gen(7);
+        std::uniform_real_distribution<double> start(0.0, 1e6 - width);
+        std::vector<double> lower_bounds(queries);
+        for (double& lower_bound : lower_bounds) {
+            lower_bound = start(gen);
+        }
+
+        double sum = 0;
+        double forward_secs = bench::time([&] {
+            for (double lower_bound : lower_bounds) {
+                auto entries = tree.range_search(lower_bound, lower_bound + width);
+                for (size_t i = 0; i < top && i < entries.size(); i++) {
+                    sum += entries[entries.size() - 1 - i].second;
+                }
+            }
+        });
+
+        double visitor_secs = bench::time([&] {
+            for (double lower_bound : lower_bounds) {
+                size_t seen = 0;
+                tree.reverse_range_search(lower_bound + width, lower_bound, [&](const double&, const double& value) {
+                    sum += value;
+                    return ++seen < top;
+                });
+            }
+        });
+
+        double iterator_secs = bench::time([&] {
+            for (double lower_bound : lower_bounds) {
+                auto it = std::make_reverse_iterator(tree.upper_bound(lower_bound + width));
+                for (size_t i = 0; i < top && it != tree.rend() && (*it).first >= lower_bound; i++, ++it) {
+                    sum += (*it).second;
+                }
+            }
+        });
+        bench::keep(sum);
+
+        std::printf("%10zu %16.2f %16.2f %16.2f\n", range_size, forward_secs * 1e6 / queries,
+            visitor_secs * 1e6 / queries, iterator_secs * 1e6 / queries);
+    }
+    return 0;
+}
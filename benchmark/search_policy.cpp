@@ -0,0 +1,78 @@
+// BPlusTree point lookups for every node search policy across key types and min degrees
+// g++ -std=c++17 -O2 [-mavx2 | -DTREES_NO_SIMD] -I../include/Trees search_policy.cpp -o search_policy && ./search_policy 1000000
+#include <cstdint>
+#include "bench.hpp"
+#include "b_plus_tree.hpp"
+
+template <typename K>
+std::vector<K> make_keys(const std::vector<double>& seeds) {
+    std::vector<K> keys;
+    keys.reserve(seeds.size());
+    for (double seed : seeds) {
+        if constexpr (std::is_same_v<K, std::string>) {
+            // fixed-width strings, so they compare in the same order as the numbers
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "key-%016.4f", seed);
+            keys.emplace_back(buffer);
+        } else {
+            keys.push_back(static_cast<K>(seed * 1000));
+        }
+    }
+    return keys;
+}
+
+template <typename K, int Degree, typename Search>
+double lookup_ns(const std::vector<K>& keys, const std::vector<K>& probes) {
+    BPlusTree<K, int, Degree, std::allocator<char>, Search> tree;
+    for (const K& key : keys) {
+        tree.insert(key, 1);
+    }
+
+    long sum = 0;
+    double secs = bench::time([&] {
+        for (const K& key : probes) {
+            sum += tree.search(key);
+        }
+    });
+    bench::keep(sum);
+    return secs * 1e9 / probes.size();
+}
+
+template <typename K, int Degree>
+void row(const char* type, const std::vector<K>& keys, const std::vector<K>& probes) {
+    std::printf("%-12s %6d %10.1f %10.1f %10.1f %10.1f\n", type, Degree,
+        lookup_ns<K, Degree, LinearSearch>(keys, probes),
+        lookup_ns<K, Degree, BinarySearch>(keys, probes),
+        lookup_ns<K, Degree, SimdSearch>(keys, probes),
+        lookup_ns<K, Degree, AdaptiveSearch>(keys, probes));
+}
+
+template <typename K>
+void run(const char* type, const std::vector<double>& seeds) {
+    auto keys = make_keys<K>(seeds);
+    auto probes = keys;
+    std::shuffle(probes.begin(), probes.end(), std::mt19937_64(7));
+
+    row<K, 4>(type, keys, probes);
+    row<K, 16>(type, keys, probes);
+    row<K, 64>(type, keys, probes);
+    row<K, 256>(type, keys, probes);
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 1000000);
+    auto seeds = bench::random_doubles(n);
+
+#if defined(TREES_NO_SIMD)
+    std::printf("n = %zu, scalar build, ns per lookup\n", n);
+#elif defined(__AVX2__)
+    std::printf("n = %zu, AVX2 build, ns per lookup\n", n);
+#else
+    std::printf("n = %zu, SSE build, ns per lookup\n", n);
+#endif
+    std::printf("%-12s %6s %10s %10s %10s %10s\n", "key", "degree", "linear", "binary", "simd", "adaptive");
+    run<int64_t>("int64_t", seeds);
+    run<double>("double", seeds);
+    run<std::string>("std::string", seeds);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// heap allocations and latency of lookups with std::string keys, with std::less<std::string> and
+// with the transparent std::less<> probed by std::string, std::string_view and const char*
+// g++ -std=c++17 -O2 -I../include/Trees string_lookup.cpp -o string_lookup && ./string_lookup 1000000
+#include <new>
+#include <string_view>
+#include "bench.hpp"
+#include "b_tree.hpp"
+#include "b_plus_tree.hpp"
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = std::malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// lookups with the probes converted by make_probe, reporting allocations and ns per lookup
+template <typename Tree, typename MakeProbe>
+void measure(const char* name, Tree& tree, const std::vector<std::string>& keys, MakeProbe make_probe) {
+    long sum = 0;
+    size_t before = allocations;
+    double secs = bench::time([&] {
+        for (const std::string& key : keys) {
+            sum += *tree.find(make_probe(key));
+        }
+    });
+    bench::keep(sum);
+    std::printf("  %-28s %8.2f allocations/lookup %10.1f ns/lookup\n", name,
+        double(allocations - before) / keys.size(), secs * 1e9 / keys.size());
+}
+
+template <typename Tree, bool Transparent>
+void run(const char* name, const std::vector<std::string>& keys) {
+    Tree tree(16);
+    for (const std::string& key : keys) {
+        tree.insert(key, 1);
+    }
+
+    auto probes = keys;
+    std::shuffle(probes.begin(), probes.end(), std::mt19937_64(7));
+
+    std::printf("%s\n", name);
+    measure("std::string", tree, probes, [](const std::string& key) -> const std::string& { return key; });
+    measure("copied std::string", tree, probes, [](const std::string& key) { return std::string(key); });
+    measure("const char*", tree, probes, [](const std::string& key) { return key.c_str(); });
+    if constexpr (Transparent) {
+        // only a transparent Compare accepts probes that do not convert implicitly to K
+        measure("std::string_view", tree, probes, [](const std::string& key) { return std::string_view(key); });
+    }
+}
+
+int main(int argc, char const* argv[]) {
+    size_t n = bench::arg_size(argc, argv, 1000000);
+
+    // transaction ids longer than the small string buffer, so every copy allocates
+    std::vector<std::string> keys;
+    std::mt19937_64 gen(42);
+    for (size_t i = 0; i < n; i++) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "TXN-%020llu", static_cast<unsigned long long>(gen()));
+        keys.emplace_back(buffer);
+    }
+    std::printf("n = %zu\n", n);
+
+    using A = std::allocator<char>;
+    run<BPlusTree<std::string, int, 16>, false>("BPlusTree<std::string, int, 16>", keys);
+    run<BPlusTree<std::string, int, 16, A, AdaptiveSearch, std::less<>>, true>("BPlusTree<..., std::less<>>", keys);
+    run<BTree<std::string, int, 16>, false>("BTree<std::string, int, 16>", keys);
+    run<BTree<std::string, int, 16, A, AdaptiveSearch, std::less<>>, true>("BTree<..., std::less<>>", keys);
+    return 0;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// aggregate policies for BTree and BPlusTree: with one, every internal node keeps a summary of each of
+// its child subtrees, which insert() keeps up to date, and range_aggregate() combines the summaries of
+// the subtrees inside a range with the entries at its two ends. A policy is a monoid over the entries:
+//   using type = ...;                                    the summary
+//   static type identity();                              summary of no entries
+//   static type lift(const K& key, const V& value);      summary of one entry
+//   static type combine(const type& a, const type& b);   summary of the entries of a followed by b's
+//   static size_t count(const type& summary);            optional, the number of entries summarized
+// combine must be associative; it is always called with a's entries before b's in key order, so it
+// need not be commutative (first or last entry, ordered concatenation). A policy with count() also
+// gives the trees the order statistics rank(), select() and count()
+
+// no summaries, the default
+struct NoAggregate {};
+
+// number of entries
+struct CountAggregate {
+    using type = size_t;
+
+    static type identity() { return 0; }
+
+    template <typename K, typename V>
+    static type lift(const K&, const V&) { return 1; }
+
+    static type combine(type a, type b) { return a + b; }
+
+    static size_t count(type summary) { return summary; }
+};
+
+// sum of the values
+template <typename V>
+struct SumAggregate {
+    using type = V;
+
+    static type identity() { return V{}; }
+
+    template <typename K>
+    static type lift(const K&, const V& value) { return value; }
+
+    static type combine(const type& a, const type& b) { return a + b; }
+};
+
+// count, sum, min and max of a set of numbers; min and max are only meaningful when count > 0
+template <typename T>
+struct NumericSummary {
+    size_t count = 0;
+    T sum{};
+    T min{};
+    T max{};
+};
+
+namespace detail {
+    // the NumericSummary part of SummaryAggregate and KeySummaryAggregate, all but lift
+    template <typename T>
+    struct numeric_summary_aggregate {
+        using type = NumericSummary<T>;
+
+        static type identity() { return type{}; }
+
+        static type combine(const type& a, const type& b) {
+            if (a.count == 0) {
+                return b;
+            } else if (b.count == 0) {
+                return a;
+            }
+            return type{a.count + b.count, a.sum + b.sum, std::min(a.min, b.min), std::max(a.max, b.max)};
+        }
+
+        static size_t count(const type& summary) { return summary.count; }
+    };
+}
+
+// count, sum, min and max of the values
+template <typename V>
+struct SummaryAggregate : detail::numeric_summary_aggregate<V> {
+    template <typename K>
+    static NumericSummary<V> lift(const K&, const V& value) { return NumericSummary<V>{1, value, value, value}; }
+};
+
+// count, sum, min and max of the keys, for trees keyed by the quantity to total (e.g. an amount)
+template <typename K>
+struct KeySummaryAggregate : detail::numeric_summary_aggregate<K> {
+    template <typename V>
+    static NumericSummary<K> lift(const K& key, const V&) { return NumericSummary<K>{1, key, key, key}; }
+};
+
+namespace detail {
+    // summary type of an aggregate policy, a placeholder for NoAggregate
+    template <typename Aggregate>
+    struct summary_of {
+        using type = typename Aggregate::type;
+    };
+
+    template <>
+    struct summary_of<NoAggregate> {
+        using type = char;
+    };
+
+    // whether the summaries of an aggregate policy count their entries
+    template <typename Aggregate, typename = void>
+    inline constexpr bool counts_entries = false;
+
+    template <typename Aggregate>
+    inline constexpr bool counts_entries<Aggregate,
+        std::void_t<decltype(Aggregate::count(std::declval<const typename Aggregate::type&>()))>> = true;
+}
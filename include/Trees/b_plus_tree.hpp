@@ -1,226 +1,1496 @@
-#pragma once
-#include <iostream>
-#include <vector>
-#include <memory>
-
-template <
-    typename K,
-    typename V>
-class BPlusTree {
-    using k__ptr = std::shared_ptr<K>;
-    using v__ptr = std::unique_ptr<V>;
-
-    struct Node {
-        int min_degree;
-        bool is_leaf;
-        std::shared_ptr<Node> parent;
-
-        Node(int min_degree, bool is_leaf) : min_degree(min_degree), is_leaf(is_leaf), parent(nullptr) {}
-
-        virtual std::pair<k__ptr, std::shared_ptr<Node>> insert(k__ptr key, v__ptr value) = 0;
-        virtual V& search(K key) = 0;
-        virtual void range_search(K lower_bound, K upper_bound, std::vector<std::pair<K, V>>& result) = 0;
-        virtual void pretty_print(int depth = 0) = 0;
-    };
-
-    struct InternalNode : public Node {
-        std::vector<k__ptr> keys;
-        std::vector<std::shared_ptr<Node>> children;
-
-        InternalNode(int min_degree) : Node(min_degree, false) {}
-
-        std::pair<k__ptr, std::shared_ptr<Node>> insert(k__ptr key, v__ptr value) override {
-            // find the index to insert the key
-            int i = 0;
-            while (i < this->keys.size() && *key > *this->keys[i]) {
-                i++;
-            }
-            
-            // insert method is called recursively on the child node at index i
-            auto [median, new_child] = this->children[i]->insert(std::move(key), std::move(value));
-
-            // if the child node was split, insert the median key and the new child node at the correct index
-            if (new_child) {
-                this->keys.insert(this->keys.begin() + i, median);
-                this->children.insert(this->children.begin() + i + 1, new_child);
-            }
-
-            // if the node is full (has more than 2 * min_degree - 1 keys), split it
-            if (this->keys.size() > 2 * this->min_degree - 1) {
-                auto median_key = this->keys[this->min_degree - 1];
-                auto right_split = std::make_shared<InternalNode>(this->min_degree);
-                //right_split->parent = this->parent;
-
-                for (int i = this->min_degree; i < this->keys.size(); i++) {
-                    right_split->keys.push_back(this->keys[i]);
-                }
-                this->keys.erase(this->keys.begin() + this->min_degree - 1, this->keys.end());
-
-                for (int i = this->min_degree; i < this->children.size(); i++) {
-                    right_split->children.push_back(this->children[i]);
-                }
-                this->children.erase(this->children.begin() + this->min_degree, this->children.end());
-
-                // return the median key and the right split node to the parent node
-                return std::make_pair(median_key, right_split);
-            }
-
-            // return nullptr if the node was not split
-            return std::make_pair(nullptr, nullptr);
-        }
-
-        V& search(K key) override {
-            int i = 0;
-            while (i < this->keys.size() && key >= *this->keys[i]) {
-                i++;
-            }
-
-            return this->children[i]->search(key);
-        }
-
-        void range_search(K lower_bound, K upper_bound, std::vector<std::pair<K, V>>& result) override {
-            int i = 0;
-            while (i < this->keys.size() && lower_bound >= *this->keys[i]) {
-                i++;
-            }
-
-            this->children[i]->range_search(lower_bound, upper_bound, result);
-        }
-
-        void pretty_print(int depth = 0) override {
-            for (int i = 0; i < this->keys.size(); i++) {
-                this->children[i]->pretty_print(depth + 1);
-                for (int j = 0; j < depth; j++) {
-                    std::cout << "  ";
-                }
-                std::cout << *this->keys[i] << std::endl;
-            }
-            this->children[this->keys.size()]->pretty_print(depth + 1);
-        }
-    };
-
-    struct LeafNode : public Node {
-        std::vector<k__ptr> keys;
-        std::vector<v__ptr> values;
-        std::shared_ptr<LeafNode> next;
-
-        LeafNode(int min_degree) : Node(min_degree, true) {}
-
-        std::pair<k__ptr, std::shared_ptr<Node>> insert(k__ptr key, v__ptr value) override {
-            // find the index to insert the key and value
-            int i = 0;
-            while (i < this->keys.size() && *key > *this->keys[i]) {
-                i++;
-            }
-
-            // insert the key and value at the correct index
-            this->keys.insert(this->keys.begin() + i, std::move(key));
-            this->values.insert(this->values.begin() + i, std::move(value));
-
-            // if the node is full (has more than 2 * min_degree - 1 keys), split it
-            if (this->keys.size() > 2 * this->min_degree - 1) {
-                auto right_split = std::make_shared<LeafNode>(this->min_degree);
-                //right_split->parent = this->parent;
-
-                for (int i = this->min_degree; i < this->keys.size(); i++) {
-                    right_split->keys.push_back(std::move(this->keys[i]));
-                    right_split->values.push_back(std::move(this->values[i]));
-                }
-
-                this->keys.erase(this->keys.begin() + this->min_degree, this->keys.end());
-                this->values.erase(this->values.begin() + this->min_degree, this->values.end());
-
-                right_split->next = this->next;
-                this->next = right_split;
-
-                // return the first key of the right split node and the right split node to the parent node
-                return std::make_pair(right_split->keys[0], right_split);
-            }
-
-            // return nullptr if the node was not split
-            return std::make_pair(nullptr, nullptr);
-        }
-
-        V& search(K key) override {
-            for (int i = 0; i < this->keys.size(); i++) {
-                if (*this->keys[i] == key) {
-                    return *this->values[i];
-                }
-            }
-
-            throw std::runtime_error("Key not found");
-        }
-
-        void range_search(K lower_bound, K upper_bound, std::vector<std::pair<K, V>>& result) override {
-            for (int i = 0; i < this->keys.size(); i++) {
-                if (*this->keys[i] >= lower_bound && *this->keys[i] <= upper_bound) {
-                    result.push_back(std::make_pair(*this->keys[i], *this->values[i]));
-                }
-            }
-
-            if (this->next != nullptr) {
-                this->next->range_search(lower_bound, upper_bound, result);
-            }
-        }
-
-        void pretty_print(int depth = 0) override {
-            for (int i = 0; i < this->keys.size(); i++) {
-                for (int j = 0; j < depth; j++) {
-                    std::cout << "   ";
-                }
-                std::cout << *this->keys[i] << ": " << *this->values[i] << std::endl;
-            }
-        }
-    };
-
-private:
-    std::shared_ptr<Node> root;
-    int min_degree;
-
-public:
-    BPlusTree(int min_degree) : min_degree(min_degree), root(nullptr) {}
-
-    void insert(K key, V value) {
-        auto k = std::make_shared<K>(key);
-        auto v = std::make_unique<V>(value);
-
-        // if the tree is empty, create a new leaf node
-        if (this->root == nullptr) {
-            auto new_root = std::make_shared<LeafNode>(this->min_degree);
-            new_root->keys.push_back(std::move(k));
-            new_root->values.push_back(std::move(v));
-
-            this->root = new_root;
-        } else {
-            // insert method is called on the root node to insert the key and value
-            auto [median, new_child] = this->root->insert(std::move(k), std::move(v));
-
-            // if the root node was split, create a new root node
-            if (new_child) {
-                auto new_root = std::make_shared<InternalNode>(this->min_degree);
-                new_root->keys.push_back(median);
-                new_root->children.push_back(this->root);
-                new_root->children.push_back(new_child);
-
-                //this->root->parent = new_root;
-                //new_child->parent = new_root;
-
-                this->root = new_root;
-            }
-        }
-    }
-
-    V& search(K key) {
-        return this->root->search(key);
-    }
-
-    std::vector<std::pair<K, V>> range_search(K lower_bound, K upper_bound) {
-        std::vector<std::pair<K, V>> result;
-        this->root->range_search(lower_bound, upper_bound, result);
-        return result;
-    }
-
-    void pretty_print() {
-        this->root->pretty_print();
-    }
-};
+#pragma once
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <thread>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+#include "node_storage.hpp"
+#include "node_search.hpp"
+#include "node_allocator.hpp"
+#include "key_error.hpp"
+#include "key_filter.hpp"
+#include "learned_index.hpp"
+#include "hash_index.hpp"
+#include "aggregate.hpp"
+
+template <typename Tree>
+class InterleavedLookup;
+
+// MinDegree > 0 fixes the degree at compile time and gives every node inline key/child arrays;
+// MinDegree == 0 keeps the degree as a constructor argument with heap-allocated node vectors.
+// Nodes are allocated through Allocator (rebound to the node type), e.g. ArenaAllocator<char>,
+// or kept in a NodePool and linked through 32-bit handles. Allocator covers the nodes only: with a
+// runtime degree their key, value and child vectors still come from std::allocator, so an arena
+// saves allocations (and the teardown walk) only with a fixed MinDegree, whose arrays are inline.
+// Search is the key search policy inside a node: AdaptiveSearch, LinearSearch, BinarySearch or SimdSearch.
+// Keys are ordered by Compare; a transparent Compare such as std::less<> lets the lookups take probes
+// of other types (std::string_view, const char* for std::string keys) without converting them to K.
+// Aggregate (see aggregate.hpp), e.g. SummaryAggregate<V>, keeps subtree summaries for range_aggregate()
+template <
+    typename K,
+    typename V,
+    int MinDegree = 0,
+    typename Allocator = std::allocator<char>,
+    typename Search = AdaptiveSearch,
+    typename Compare = std::less<K>,
+    typename Aggregate = NoAggregate>
+class BPlusTree {
+    static_assert(MinDegree == 0 || MinDegree >= 2, "min degree must be at least 2");
+
+    using k__slot = detail::slot<K>;
+    using v__slot = detail::slot<V>;
+
+    // a node holds up to 2 * min_degree - 1 keys, plus one extra key before it is split
+    static constexpr int key_capacity = MinDegree > 0 ? 2 * MinDegree : 0;
+    static constexpr int child_capacity = MinDegree > 0 ? 2 * MinDegree + 1 : 0;
+
+    using key_array = detail::node_array<typename k__slot::type, key_capacity>;
+
+    struct Node;
+    struct InternalNode;
+    struct LeafNode;
+
+    using leaf_store = detail::node_store<LeafNode, Allocator>;
+    using internal_store = detail::node_store<InternalNode, Allocator>;
+    using leaf_handle = typename leaf_store::handle;
+    using internal_handle = typename internal_store::handle;
+
+    // links to children are pointers, or in pool mode 32-bit indices where the top bit
+    // tells whether the index is into the leaf pool or the internal node pool
+    static constexpr bool pooled = detail::is_node_pool<Allocator>;
+    static constexpr uint32_t leaf_tag = uint32_t(1) << 31;
+    using node_handle = std::conditional_t<pooled, uint32_t, Node*>;
+
+    static constexpr bool aggregated = !std::is_same_v<Aggregate, NoAggregate>;
+    using summary_type = typename detail::summary_of<Aggregate>::type;
+
+    // node header; the kind of node is given by is_leaf and dispatched statically, without a vtable
+    struct Node {
+        bool is_leaf;
+
+        Node(bool is_leaf) : is_leaf(is_leaf) {}
+
+        InternalNode* as_internal() { return static_cast<InternalNode*>(this); }
+        LeafNode* as_leaf() { return static_cast<LeafNode*>(this); }
+
+        void pretty_print(BPlusTree& tree, int depth = 0) {
+            if (this->is_leaf) {
+                this->as_leaf()->pretty_print(depth);
+            } else {
+                this->as_internal()->pretty_print(tree, depth);
+            }
+        }
+    };
+
+    struct InternalNode : public Node {
+        // separators are copies of the first key of the right subtree, owned by this node
+        key_array keys;
+        detail::node_array<node_handle, child_capacity> children;
+        // with an aggregate policy, the summary of each child subtree
+        std::conditional_t<aggregated, detail::node_array<summary_type, child_capacity>, char> summaries;
+
+        InternalNode() : Node(false) {}
+
+        K& key(int i) { return k__slot::get(this->keys[i]); }
+
+        // insert the separator and the new right node of a split child at index i
+        void insert_child(int i, typename k__slot::type key, node_handle right) {
+            this->keys.insert(this->keys.begin() + i, std::move(key));
+            this->children.insert(this->children.begin() + i + 1, right);
+        }
+
+        // move the keys and children after the median into right, and return the median key
+        typename k__slot::type split(InternalNode* right, int min_degree) {
+            auto median_key = std::move(this->keys[min_degree - 1]);
+
+            for (int i = min_degree; i < this->keys.size(); i++) {
+                right->keys.push_back(std::move(this->keys[i]));
+            }
+            this->keys.erase(this->keys.begin() + min_degree - 1, this->keys.end());
+
+            for (int i = min_degree; i < this->children.size(); i++) {
+                right->children.push_back(this->children[i]);
+            }
+            this->children.erase(this->children.begin() + min_degree, this->children.end());
+
+            if constexpr (aggregated) {
+                for (int i = min_degree; i < this->summaries.size(); i++) {
+                    right->summaries.push_back(std::move(this->summaries[i]));
+                }
+                this->summaries.erase(this->summaries.begin() + min_degree, this->summaries.end());
+            }
+
+            return median_key;
+        }
+
+        // summary of the children in [first, last)
+        summary_type summarize(int first, int last) const {
+            summary_type result = Aggregate::identity();
+            for (int i = first; i < last; i++) {
+                result = Aggregate::combine(result, this->summaries[i]);
+            }
+            return result;
+        }
+
+        // child to descend into when looking for key
+        template <typename Key>
+        node_handle child(const Compare& compare, const Key& key) {
+            return this->children[detail::upper_rank<Search, k__slot>(this->keys, key, compare)];
+        }
+
+        void pretty_print(BPlusTree& tree, int depth = 0) {
+            for (int i = 0; i < this->keys.size(); i++) {
+                tree.node(this->children[i])->pretty_print(tree, depth + 1);
+                for (int j = 0; j < depth; j++) {
+                    std::cout << "  ";
+                }
+                std::cout << this->key(i) << std::endl;
+            }
+            tree.node(this->children[this->keys.size()])->pretty_print(tree, depth + 1);
+        }
+    };
+
+    struct LeafNode : public Node {
+        key_array keys;
+        detail::node_array<typename v__slot::type, key_capacity> values;
+        leaf_handle next;
+        leaf_handle prev;
+
+        LeafNode() : Node(true), next(leaf_store::null_handle), prev(leaf_store::null_handle) {}
+
+        K& key(int i) { return k__slot::get(this->keys[i]); }
+        V& value(int i) { return v__slot::get(this->values[i]); }
+
+        void insert(const Compare& compare, typename k__slot::type key, typename v__slot::type value) {
+            // find the index to insert the key and value
+            int i = detail::lower_rank<Search, k__slot>(this->keys, k__slot::get(key), compare);
+
+            // insert the key and value at the correct index
+            this->keys.insert(this->keys.begin() + i, std::move(key));
+            this->values.insert(this->values.begin() + i, std::move(value));
+        }
+
+        // move the upper half of the entries into right, link it after this leaf (the caller points the
+        // prev link of the leaf after right back to it), and return a copy of its first key as the
+        // separator for the parent node
+        typename k__slot::type split(LeafNode* right, leaf_handle handle, leaf_handle right_handle, int min_degree) {
+            for (int i = min_degree; i < this->keys.size(); i++) {
+                right->keys.push_back(std::move(this->keys[i]));
+                right->values.push_back(std::move(this->values[i]));
+            }
+
+            this->keys.erase(this->keys.begin() + min_degree, this->keys.end());
+            this->values.erase(this->values.begin() + min_degree, this->values.end());
+
+            right->next = this->next;
+            right->prev = handle;
+            this->next = right_handle;
+
+            return k__slot::make(K(right->key(0)));
+        }
+
+        // keys and values are parallel arrays: the searches below only scan the dense key array
+        // and touch values for the matching slots
+
+        // value stored for key in this leaf, or nullptr
+        template <typename Key>
+        V* find(const Compare& compare, const Key& key) {
+            // keys[i] is the first key not smaller than key
+            auto [i, equal] = detail::locate<Search, k__slot>(this->keys, key, compare);
+            if (equal) {
+                return &this->value(i);
+            }
+            return nullptr;
+        }
+
+        // pass the entries of this leaf within [lower_bound, upper_bound] to visit; returns false when
+        // the scan is over, because the leaf ends past upper_bound or visit has asked to stop
+        template <typename Lower, typename Upper, typename Visitor>
+        bool range_search(const Compare& compare, const Lower& lower_bound, const Upper& upper_bound, Visitor& visit) {
+            int first = detail::lower_rank<Search, k__slot>(this->keys, lower_bound, compare);
+            int last = detail::upper_rank<Search, k__slot>(this->keys, upper_bound, compare);
+
+            for (int i = first; i < last; i++) {
+                if (!detail::visit_entry(visit, this->key(i), this->value(i))) {
+                    return false;
+                }
+            }
+
+            return last == this->keys.size();
+        }
+
+        // range_search() in descending key order; returns false when the scan is over, because the leaf
+        // starts before lower_bound or visit has asked to stop
+        template <typename Lower, typename Upper, typename Visitor>
+        bool reverse_range_search(const Compare& compare, const Lower& lower_bound, const Upper& upper_bound,
+                                  Visitor& visit) {
+            int first = detail::lower_rank<Search, k__slot>(this->keys, lower_bound, compare);
+            int last = detail::upper_rank<Search, k__slot>(this->keys, upper_bound, compare);
+
+            for (int i = last - 1; i >= first; i--) {
+                if (!detail::visit_entry(visit, this->key(i), this->value(i))) {
+                    return false;
+                }
+            }
+
+            return first == 0;
+        }
+
+        // summary of the entries in [first, last)
+        summary_type summarize(int first, int last) {
+            summary_type result = Aggregate::identity();
+            for (int i = first; i < last; i++) {
+                result = Aggregate::combine(result, Aggregate::lift(this->key(i), this->value(i)));
+            }
+            return result;
+        }
+
+        void pretty_print(int depth = 0) {
+            for (int i = 0; i < this->keys.size(); i++) {
+                for (int j = 0; j < depth; j++) {
+                    std::cout << "   ";
+                }
+                std::cout << this->key(i) << ": " << this->value(i) << std::endl;
+            }
+        }
+    };
+
+private:
+    // bound on the height of the tree, used to size the insertion path
+    static constexpr int max_height = 64;
+
+    // number of lookups multi_search keeps in flight
+    static constexpr size_t batch_group = 16;
+
+    // build with -DTREES_NO_FINGER to always descend from the root
+#if defined(TREES_NO_FINGER)
+    static constexpr bool use_finger = false;
+#else
+    static constexpr bool use_finger = true;
+#endif
+
+    // leaf of the last insert that descended from the root without splitting it, with copies of the
+    // separators around it (its fences, unset at the ends of the tree). A key strictly between the fences
+    // belongs to that leaf under both the insert and the lookup descent, so sequential and clustered
+    // inserts, and lookups once enable_finger_lookups() is called, can go straight to it. Only insert()
+    // moves the finger, so lookups never write
+    struct finger_cache {
+        leaf_handle leaf = leaf_store::null_handle;
+        std::optional<K> low;
+        std::optional<K> high;
+    };
+
+    node_handle root;
+    int min_degree;
+    leaf_store leaves;
+    internal_store internals;
+    Compare compare;
+    finger_cache finger;
+    // whether find() tries the finger leaf before descending (see enable_finger_lookups)
+    bool finger_lookups = false;
+    KeyFilter filter;
+
+    // learned index over the first keys of the leaves (see build_learned_index), with the leaf of each
+    // key; learned_error is 0 while it is off
+    std::conditional_t<std::is_arithmetic_v<K>, LearnedIndex<K>, char> learned;
+    std::vector<leaf_handle> learned_leaves;
+    int learned_error = 0;
+    size_t learned_splits = 0;
+    // leaves learned_leaf() follows along the chain from the predicted one before it gives up on the
+    // model, so that appends after the last indexed leaf cannot make a lookup walk every split
+    static constexpr int learned_max_hops = 8;
+
+    // exact-match index from key hashes to leaves (see enable_hash_index)
+    HashIndex<leaf_handle> hash_index{leaf_store::null_handle};
+
+    int degree() const {
+        if constexpr (MinDegree > 0) {
+            return MinDegree;
+        } else {
+            return this->min_degree;
+        }
+    }
+
+    static constexpr node_handle null_node = pooled ? node_handle(leaf_store::null_handle) : node_handle();
+
+    Node* node(node_handle handle) const {
+        if constexpr (pooled) {
+            if (handle & leaf_tag) {
+                return this->leaves.get(handle & ~leaf_tag);
+            }
+            return this->internals.get(handle);
+        } else {
+            return handle;
+        }
+    }
+
+    static node_handle leaf_link(leaf_handle handle) {
+        if constexpr (pooled) {
+            return handle | leaf_tag;
+        } else {
+            return handle;
+        }
+    }
+
+    static node_handle internal_link(internal_handle handle) {
+        return handle;
+    }
+
+    static leaf_handle leaf_of(node_handle handle) {
+        if constexpr (pooled) {
+            return handle & ~leaf_tag;
+        } else {
+            return static_cast<LeafNode*>(handle);
+        }
+    }
+
+    // copy-assign, so a fence keeps its storage (e.g. a std::string buffer) from one descent to the next
+    static void set_fence(std::optional<K>& fence, const K* key) {
+        if (key != nullptr) {
+            fence = *key;
+        } else {
+            fence.reset();
+        }
+    }
+
+    // the finger leaf when key lies strictly between its fences, otherwise nullptr
+    template <typename Key>
+    LeafNode* finger_leaf(const Key& key) const {
+        if constexpr (use_finger) {
+            const finger_cache& finger = this->finger;
+            if (finger.leaf == leaf_store::null_handle || (finger.low && !this->compare(*finger.low, key)) ||
+                (finger.high && !this->compare(key, *finger.high))) {
+                return nullptr;
+            }
+            return this->leaves.get(finger.leaf);
+        } else {
+            return nullptr;
+        }
+    }
+
+    // descend from the root to the leaf that may hold key
+    template <typename Key>
+    LeafNode* find_leaf(const Key& key) {
+        Node* node = this->node(this->root);
+        while (!node->is_leaf) {
+            node = this->node(node->as_internal()->child(this->compare, key));
+        }
+        return node->as_leaf();
+    }
+
+    // start of the leaf chain; the tree must not be empty
+    leaf_handle first_leaf() const {
+        node_handle handle = this->root;
+        while (!this->node(handle)->is_leaf) {
+            handle = this->node(handle)->as_internal()->children[0];
+        }
+        return leaf_of(handle);
+    }
+
+    // end of the leaf chain; the tree must not be empty
+    leaf_handle last_leaf() const {
+        node_handle handle = this->root;
+        while (!this->node(handle)->is_leaf) {
+            handle = this->node(handle)->as_internal()->children.back();
+        }
+        return leaf_of(handle);
+    }
+
+    // descend from the root to the leftmost leaf that may hold key or anything greater;
+    // copies of a separator can also sit at the end of the left sibling
+    template <typename Key>
+    LeafNode* lower_leaf(const Key& key) {
+        Node* node = this->node(this->root);
+        while (!node->is_leaf) {
+            auto internal = node->as_internal();
+            node = this->node(internal->children[detail::lower_rank<Search, k__slot>(internal->keys, key, this->compare)]);
+        }
+        return node->as_leaf();
+    }
+
+    // start loading the header and key array of a node, the part that a search reads; both kinds
+    // of node start with them, so this needs neither is_leaf nor any other load from the node
+    static void prefetch(const Node* node) {
+        detail::prefetch(node, sizeof(Node) + alignof(key_array) + sizeof(key_array));
+    }
+
+    // a lookup advanced one node at a time, for lookups that are interleaved with others
+    // (InterleavedLookup): lookup_root() is the first node to search (nullptr when the tree is
+    // empty), and lookup_step() searches node for key and either finishes at a leaf, setting
+    // result to the value or nullptr, or moves node to the child to search next and prefetches it
+    using lookup_cursor = Node*;
+
+    lookup_cursor lookup_root() const {
+        return this->root == null_node ? nullptr : this->node(this->root);
+    }
+
+    bool lookup_step(lookup_cursor& node, const K& key, V*& result) {
+        if (node == nullptr) {
+            result = nullptr;
+            return true;
+        } else if (node->is_leaf) {
+            result = node->as_leaf()->find(this->compare, key);
+            return true;
+        }
+
+        node = this->node(node->as_internal()->child(this->compare, key));
+        prefetch(node);
+        return false;
+    }
+
+    template <typename Tree>
+    friend class InterleavedLookup;
+
+    // a new model of the leaf chain as it is now
+    void rebuild_learned_index() {
+        std::vector<K> first_keys;
+        this->learned_leaves.clear();
+        if (this->root != null_node) {
+            leaf_handle handle = this->first_leaf();
+            while (handle != leaf_store::null_handle) {
+                LeafNode* leaf = this->leaves.get(handle);
+                first_keys.push_back(leaf->key(0));
+                this->learned_leaves.push_back(handle);
+                handle = leaf->next;
+            }
+        }
+        this->learned = LearnedIndex<K>(std::move(first_keys), this->learned_error);
+        this->learned_splits = 0;
+    }
+
+    // leaf that holds key according to the learned index, or nullptr without one: the leaf the model
+    // finds among those it was built from, or one of the leaves split off it since, which follow it in
+    // the chain before the next indexed leaf. Also nullptr when more than learned_max_hops of those
+    // stand between the two, and the caller descends instead
+    template <typename Key>
+    LeafNode* learned_leaf(const Key& key) const {
+        if constexpr (std::is_arithmetic_v<K> && std::is_same_v<Key, K> && detail::is_plain_less<Compare, K>) {
+            if (this->learned_leaves.empty()) {
+                return nullptr;
+            }
+
+            int i = this->learned.rank(key);
+            leaf_handle end = static_cast<size_t>(i) + 1 < this->learned_leaves.size() ? this->learned_leaves[i + 1] : leaf_store::null_handle;
+            LeafNode* leaf = this->leaves.get(this->learned_leaves[i]);
+            for (int hops = 0; leaf->next != end && !this->compare(key, this->leaves.get(leaf->next)->key(0)); hops++) {
+                if (hops == learned_max_hops) {
+                    return nullptr;
+                }
+                leaf = this->leaves.get(leaf->next);
+            }
+            return leaf;
+        } else {
+            return nullptr;
+        }
+    }
+
+    // bytes of the internal nodes below handle
+    size_t internal_bytes(node_handle handle) const {
+        Node* node = this->node(handle);
+        if (node->is_leaf) {
+            return 0;
+        }
+
+        auto internal = node->as_internal();
+        size_t bytes = sizeof(InternalNode);
+        if constexpr (MinDegree == 0) {
+            bytes += internal->keys.capacity() * sizeof(typename k__slot::type) + internal->children.capacity() * sizeof(node_handle);
+        }
+        for (node_handle child : internal->children) {
+            bytes += this->internal_bytes(child);
+        }
+        return bytes;
+    }
+
+    // a new filter of the keys in the tree, with room for as many again
+    void rebuild_filter(int bits_per_key) {
+        std::vector<uint64_t> hashes;
+        if (this->root != null_node) {
+            leaf_handle handle = this->first_leaf();
+            while (handle != leaf_store::null_handle) {
+                LeafNode* leaf = this->leaves.get(handle);
+                for (int i = 0; i < leaf->keys.size(); i++) {
+                    hashes.push_back(detail::key_hash<K>(leaf->key(i)));
+                }
+                handle = leaf->next;
+            }
+        }
+
+        this->filter = KeyFilter(std::max<size_t>(2 * hashes.size(), 1024), bits_per_key);
+        for (uint64_t hash : hashes) {
+            this->filter.add(hash);
+        }
+    }
+
+    // record in the hash index that the key with this hash was put in leaf
+    void index_key(uint64_t hash, leaf_handle leaf) {
+        if constexpr (detail::is_hashable<K>) {
+            if (this->hash_index.enabled()) {
+                this->hash_index.add(hash, leaf);
+            }
+        }
+    }
+
+    void destroy(node_handle handle) {
+        Node* node = this->node(handle);
+        if (node->is_leaf) {
+            if constexpr (pooled) {
+                this->leaves.destroy(handle & ~leaf_tag);
+            } else {
+                this->leaves.destroy(node->as_leaf());
+            }
+        } else {
+            for (node_handle child : node->as_internal()->children) {
+                this->destroy(child);
+            }
+            if constexpr (pooled) {
+                this->internals.destroy(handle);
+            } else {
+                this->internals.destroy(node->as_internal());
+            }
+        }
+    }
+
+    void release() {
+        // an arena allocator releases trivially destructible nodes all at once
+        if constexpr (!(leaf_store::bulk_release && internal_store::bulk_release)) {
+            if (this->root != null_node) {
+                this->destroy(this->root);
+            }
+        }
+    }
+
+    // move the finger, filter, learned index and hash index of other into this tree, turning them off in other
+    void take_extras(BPlusTree& other) {
+        this->finger = std::exchange(other.finger, finger_cache{});
+        this->finger_lookups = std::exchange(other.finger_lookups, false);
+        this->filter = std::exchange(other.filter, KeyFilter());
+        this->learned = std::exchange(other.learned, decltype(this->learned){});
+        this->learned_leaves = std::exchange(other.learned_leaves, {});
+        this->learned_error = std::exchange(other.learned_error, 0);
+        this->learned_splits = std::exchange(other.learned_splits, 0);
+        this->hash_index = std::exchange(other.hash_index, HashIndex<leaf_handle>(leaf_store::null_handle));
+    }
+
+    // summary of the entries under handle
+    summary_type summarize(node_handle handle) const {
+        Node* node = this->node(handle);
+        if (node->is_leaf) {
+            return node->as_leaf()->summarize(0, node->as_leaf()->keys.size());
+        }
+        return node->as_internal()->summarize(0, node->as_internal()->children.size());
+    }
+
+    // summary of the entries under handle within [lower_bound, upper_bound]; a bound that is not checked
+    // is known to hold for the whole subtree. Only the children at a checked bound are searched, the
+    // others inside the range count through their summaries
+    template <typename Lower, typename Upper>
+    summary_type aggregate_range(node_handle handle, const Lower& lower_bound, const Upper& upper_bound,
+                                 bool check_lower, bool check_upper) const {
+        Node* node = this->node(handle);
+        if (node->is_leaf) {
+            LeafNode* leaf = node->as_leaf();
+            int first = check_lower ? detail::lower_rank<Search, k__slot>(leaf->keys, lower_bound, this->compare) : 0;
+            int last = check_upper ? detail::upper_rank<Search, k__slot>(leaf->keys, upper_bound, this->compare)
+                                   : leaf->keys.size();
+            return leaf->summarize(first, last);
+        }
+
+        // the keys of children[i] lie between the separators i - 1 and i, both included
+        InternalNode* internal = node->as_internal();
+        int first = check_lower ? detail::lower_rank<Search, k__slot>(internal->keys, lower_bound, this->compare) : 0;
+        int last = check_upper ? detail::upper_rank<Search, k__slot>(internal->keys, upper_bound, this->compare)
+                               : internal->keys.size();
+        if (first == last) {
+            return this->aggregate_range(internal->children[first], lower_bound, upper_bound, check_lower, check_upper);
+        }
+
+        summary_type result = check_lower
+            ? this->aggregate_range(internal->children[first], lower_bound, upper_bound, true, false)
+            : internal->summaries[first];
+        result = Aggregate::combine(result, internal->summarize(first + 1, last));
+        return Aggregate::combine(result, check_upper
+            ? this->aggregate_range(internal->children[last], lower_bound, upper_bound, false, true)
+            : internal->summaries[last]);
+    }
+
+    // number of separators parallel_range_scan() gathers per chunk, to balance chunks of subtrees
+    // whose sizes differ up to twice
+    static constexpr size_t separators_per_chunk = 8;
+
+    // entries an ordered parallel_range_scan() worker hands to the calling thread at a time, and the
+    // batches it may have waiting before it pauses, which bound the memory of an ordered scan
+    static constexpr size_t ordered_batch = 1024;
+    static constexpr size_t ordered_batches = 4;
+
+    // the entries of an ordered chunk that its worker has scanned and the calling thread has not visited
+    // yet, recorded as the key and value of each slot
+    struct ordered_chunk {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<std::vector<std::pair<const K*, const V*>>> batches;
+        bool done = false;
+
+        // hand batch to the calling thread, waiting while ordered_batches are; false once stopped
+        bool push(std::vector<std::pair<const K*, const V*>>&& batch, const std::atomic<bool>& stopped) {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->changed.wait(lock, [&] {
+                return this->batches.size() < ordered_batches || stopped.load(std::memory_order_relaxed);
+            });
+            if (stopped.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            this->batches.push_back(std::move(batch));
+            this->changed.notify_all();
+            return true;
+        }
+
+        // the worker has no more batches
+        void finish() {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->done = true;
+            this->changed.notify_all();
+        }
+
+        // the next batch, empty once the worker has finished and every batch was taken
+        std::vector<std::pair<const K*, const V*>> pop() {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->changed.wait(lock, [&] { return !this->batches.empty() || this->done; });
+            std::vector<std::pair<const K*, const V*>> batch;
+            if (!this->batches.empty()) {
+                batch = std::move(this->batches.front());
+                this->batches.pop_front();
+                this->changed.notify_all();
+            }
+            return batch;
+        }
+    };
+
+    // stop every chunk of a parallel scan, waking the workers waiting for the calling thread
+    static void stop_chunks(std::atomic<bool>& stopped, std::vector<ordered_chunk>& chunks) {
+        stopped.store(true, std::memory_order_relaxed);
+        for (ordered_chunk& chunk : chunks) {
+            std::lock_guard<std::mutex> lock(chunk.mutex);
+            chunk.changed.notify_all();
+        }
+    }
+
+    // separators strictly after lower_bound and not after upper_bound that cut the range into at most
+    // chunks parts of about the same number of subtrees: the internal nodes covering the range are read
+    // level by level, down to the level with enough separators or to the parents of the leaves
+    template <typename Lower, typename Upper>
+    std::vector<const K*> split_keys(const Lower& lower_bound, const Upper& upper_bound, size_t chunks) {
+        std::vector<const K*> separators;
+        std::vector<InternalNode*> level;
+        if (this->root != null_node && !this->node(this->root)->is_leaf) {
+            level.push_back(this->node(this->root)->as_internal());
+        }
+        while (!level.empty()) {
+            separators.clear();
+            std::vector<InternalNode*> next;
+            for (InternalNode* internal : level) {
+                int first = detail::lower_rank<Search, k__slot>(internal->keys, lower_bound, this->compare);
+                int last = detail::upper_rank<Search, k__slot>(internal->keys, upper_bound, this->compare);
+                for (int i = first; i < last; i++) {
+                    if (this->compare(lower_bound, internal->key(i))) {
+                        separators.push_back(&internal->key(i));
+                    }
+                }
+                for (int i = first; i <= last; i++) {
+                    Node* child = this->node(internal->children[i]);
+                    if (!child->is_leaf) {
+                        next.push_back(child->as_internal());
+                    }
+                }
+            }
+            if (separators.size() >= chunks * separators_per_chunk) {
+                break;
+            }
+            level = std::move(next);
+        }
+
+        // every separators.size() / chunks-th separator, skipping repeats of a key
+        std::vector<const K*> result;
+        for (size_t c = 1; c < chunks; c++) {
+            const K* separator = separators.empty() ? nullptr : separators[c * separators.size() / chunks];
+            if (separator != nullptr && (result.empty() || this->compare(*result.back(), *separator))) {
+                result.push_back(separator);
+            }
+        }
+        return result;
+    }
+
+    // pass the entries from lower_bound up to upper_bound, included when UpperIncluded, to visit;
+    // returns false once visit has asked to stop
+    template <bool UpperIncluded, typename Lower, typename Upper, typename Visitor>
+    bool scan_chunk(const Lower& lower_bound, const Upper& upper_bound, Visitor& visit) {
+        LeafNode* leaf = this->lower_leaf(lower_bound);
+        int i = detail::lower_rank<Search, k__slot>(leaf->keys, lower_bound, this->compare);
+        while (true) {
+            int last = UpperIncluded ? detail::upper_rank<Search, k__slot>(leaf->keys, upper_bound, this->compare)
+                                     : detail::lower_rank<Search, k__slot>(leaf->keys, upper_bound, this->compare);
+            for (; i < last; i++) {
+                if (!detail::visit_entry(visit, leaf->key(i), leaf->value(i))) {
+                    return false;
+                }
+            }
+            if (last < leaf->keys.size() || leaf->next == leaf_store::null_handle) {
+                return true;
+            }
+            leaf = this->leaves.get(leaf->next);
+            i = 0;
+        }
+    }
+
+public:
+    // with a compile-time MinDegree the argument is only kept for compatibility and must match it
+    BPlusTree(int min_degree, const Allocator& allocator = Allocator(), const Compare& compare = Compare())
+        : min_degree(min_degree), root(null_node), leaves(allocator), internals(allocator), compare(compare) {
+        assert(min_degree >= 2);
+        assert(MinDegree == 0 || min_degree == MinDegree);
+    }
+
+    // only a compile-time MinDegree can be left out, a runtime degree has no sensible default
+    template <int D = MinDegree, std::enable_if_t<(D > 0), int> = 0>
+    BPlusTree() : BPlusTree(MinDegree) {}
+
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+
+    // the nodes and the finger, filter, learned index and hash index move with the tree; the moved-from
+    // tree is left empty, with its degree and allocator and without the side structures
+    BPlusTree(BPlusTree&& other) noexcept
+        : min_degree(other.min_degree), root(std::exchange(other.root, null_node)), leaves(std::move(other.leaves)),
+          internals(std::move(other.internals)), compare(other.compare) {
+        this->take_extras(other);
+    }
+
+    BPlusTree& operator=(BPlusTree&& other) noexcept {
+        if (this != &other) {
+            this->release();
+            this->root = std::exchange(other.root, null_node);
+            this->min_degree = other.min_degree;
+            this->leaves = std::move(other.leaves);
+            this->internals = std::move(other.internals);
+            this->compare = other.compare;
+            this->take_extras(other);
+        }
+        return *this;
+    }
+
+    ~BPlusTree() {
+        this->release();
+    }
+
+    void insert(K key, V value) {
+        // the key is hashed once for the filter and the hash index, when either is kept
+        uint64_t hash = 0;
+        if constexpr (detail::is_hashable<K>) {
+            if (this->filter.enabled() || this->hash_index.enabled()) {
+                hash = detail::key_hash<K>(key);
+            }
+            if (this->filter.enabled()) {
+                if (this->filter.full()) {
+                    this->rebuild_filter(this->filter.bits_per_key());
+                }
+                this->filter.add(hash);
+            }
+        }
+
+        // once the leaves split since the learned index was built are an eighth of the ones it indexes,
+        // the walks along the chain are no longer short: build it again
+        if constexpr (std::is_arithmetic_v<K>) {
+            if (this->learned_error > 0 && this->learned_splits > this->learned_leaves.size() / 8) {
+                this->rebuild_learned_index();
+            }
+        }
+
+        auto k = k__slot::make(std::move(key));
+        auto v = v__slot::make(std::move(value));
+
+        // if the tree is empty, create a new leaf node
+        if (this->root == null_node) {
+            leaf_handle new_root = this->leaves.create();
+            this->leaves.get(new_root)->keys.push_back(std::move(k));
+            this->leaves.get(new_root)->values.push_back(std::move(v));
+            this->index_key(hash, new_root);
+
+            this->root = leaf_link(new_root);
+            return;
+        }
+
+        // the finger leaf takes the key without a descent as long as it does not have to be split
+        int min_degree = this->degree();
+        LeafNode* finger = this->finger_leaf(k__slot::get(k));
+        if (!aggregated && finger != nullptr && static_cast<int>(finger->keys.size()) < 2 * min_degree - 1) {
+            finger->insert(this->compare, std::move(k), std::move(v));
+            this->index_key(hash, this->finger.leaf);
+            return;
+        }
+
+        // descend to the leaf, remembering the path in case the leaf has to be split,
+        // and the closest separators on either side of it for the finger
+        InternalNode* path[max_height];
+        int path_index[max_height];
+        int depth = 0;
+        const K* low = nullptr;
+        const K* high = nullptr;
+
+        node_handle handle = this->root;
+        Node* node = this->node(handle);
+        while (!node->is_leaf) {
+            auto internal = node->as_internal();
+            int i = detail::lower_rank<Search, k__slot>(internal->keys, k__slot::get(k), this->compare);
+            if (i > 0) {
+                low = &internal->key(i - 1);
+            }
+            if (i < internal->keys.size()) {
+                high = &internal->key(i);
+            }
+            path[depth] = internal;
+            path_index[depth] = i;
+            depth++;
+            handle = internal->children[i];
+            node = this->node(handle);
+        }
+
+        LeafNode* leaf = node->as_leaf();
+        leaf->insert(this->compare, std::move(k), std::move(v));
+        this->index_key(hash, leaf_of(handle));
+
+        // summarize the subtrees on the path again from the bottom up, so that every summary combines
+        // its entries in key order
+        if constexpr (aggregated) {
+            for (int d = depth - 1; d >= 0; d--) {
+                path[d]->summaries[path_index[d]] = this->summarize(path[d]->children[path_index[d]]);
+            }
+        }
+
+        // if the node is full (has more than 2 * min_degree - 1 keys), split it
+        if (static_cast<int>(leaf->keys.size()) <= 2 * min_degree - 1) {
+            if constexpr (use_finger) {
+                this->finger.leaf = leaf_of(handle);
+                set_fence(this->finger.low, low);
+                set_fence(this->finger.high, high);
+            }
+            return;
+        }
+
+        // the split narrows the range of the leaf, the next insert descends again
+        this->finger.leaf = leaf_store::null_handle;
+        this->learned_splits++;
+
+        leaf_handle right_leaf = this->leaves.create();
+        LeafNode* right = this->leaves.get(right_leaf);
+        auto separator = leaf->split(right, leaf_of(handle), right_leaf, min_degree);
+        if (right->next != leaf_store::null_handle) {
+            this->leaves.get(right->next)->prev = right_leaf;
+        }
+        node_handle right_split = leaf_link(right_leaf);
+
+        // the upper half of the keys moved to the right leaf
+        if constexpr (detail::is_hashable<K>) {
+            if (this->hash_index.enabled()) {
+                for (int i = 0; i < right->keys.size(); i++) {
+                    this->hash_index.move(detail::key_hash<K>(right->key(i)), leaf_of(handle), right_leaf);
+                }
+            }
+        }
+
+        // insert the separator and the right split node into the parent, splitting it in turn when full
+        while (depth > 0) {
+            depth--;
+            InternalNode* parent = path[depth];
+            parent->insert_child(path_index[depth], std::move(separator), right_split);
+            if constexpr (aggregated) {
+                // the split child and its new right sibling each summarize their part of the entries
+                int i = path_index[depth];
+                parent->summaries[i] = this->summarize(parent->children[i]);
+                parent->summaries.insert(parent->summaries.begin() + i + 1, this->summarize(right_split));
+            }
+            if (static_cast<int>(parent->keys.size()) <= 2 * min_degree - 1) {
+                return;
+            }
+
+            internal_handle right_internal = this->internals.create();
+            separator = parent->split(this->internals.get(right_internal), min_degree);
+            right_split = internal_link(right_internal);
+        }
+
+        // the root node was split, create a new root node
+        internal_handle new_root = this->internals.create();
+        InternalNode* root_node = this->internals.get(new_root);
+        root_node->keys.push_back(std::move(separator));
+        root_node->children.push_back(this->root);
+        root_node->children.push_back(right_split);
+        if constexpr (aggregated) {
+            root_node->summaries.push_back(this->summarize(this->root));
+            root_node->summaries.push_back(this->summarize(right_split));
+        }
+        this->root = internal_link(new_root);
+    }
+
+    // pointer to the value stored for key, or nullptr when the key is missing;
+    // a miss costs the same descent as a hit and never throws.
+    // The lookups take keys by reference: key is used as is with a transparent Compare, and is
+    // converted to K (once, not per node) otherwise
+    template <typename Key>
+    V* find(const Key& key) {
+        if (this->root == null_node) {
+            return nullptr;
+        }
+        const detail::probe_t<Compare, K, Key>& probe = key;
+        if constexpr (detail::is_hash_probe<K, detail::probe_t<Compare, K, Key>>) {
+            if (this->hash_index.enabled()) {
+                return this->hash_index.template find<V>(detail::key_hash<K>(probe), [&](leaf_handle leaf) {
+                    return this->leaves.get(leaf)->find(this->compare, probe);
+                });
+            }
+        }
+        if (!this->may_contain(probe)) {
+            return nullptr;
+        }
+        LeafNode* leaf = this->finger_lookups ? this->finger_leaf(probe) : nullptr;
+        if (leaf == nullptr) {
+            leaf = this->learned_leaf(probe);
+        }
+        if (leaf == nullptr) {
+            leaf = this->find_leaf(probe);
+        }
+        return leaf->find(this->compare, probe);
+    }
+
+    template <typename Key>
+    bool contains(const Key& key) {
+        return this->find(key) != nullptr;
+    }
+
+    // copy the value stored for key into value; returns false (leaving value untouched) on a miss
+    template <typename Key>
+    bool try_get(const Key& key, V& value) {
+        V* found = this->find(key);
+        if (found == nullptr) {
+            return false;
+        }
+        value = *found;
+        return true;
+    }
+
+    // throws std::runtime_error on a miss (see key_error.hpp)
+    template <typename Key>
+    V& search(const Key& key) {
+        V* found = this->find(key);
+        if (found == nullptr) {
+            detail::key_not_found("Key not found");
+        }
+        return *found;
+    }
+
+    // find() for count keys at once, writing the results in input order: the lookups advance one
+    // level at a time in groups of batch_group, and every child is prefetched before the next
+    // lookup of the group is advanced, so the cache misses of the group overlap
+    void multi_search(const K* keys, size_t count, V** results) {
+        if (this->root == null_node) {
+            std::fill(results, results + count, nullptr);
+            return;
+        }
+
+        Node* nodes[batch_group];
+        for (size_t first = 0; first < count; first += batch_group) {
+            size_t size = std::min(batch_group, count - first);
+            for (size_t j = 0; j < size; j++) {
+                nodes[j] = this->node(this->root);
+            }
+
+            // all leaves are at the same depth, so the lookups of a group reach them together
+            while (!nodes[0]->is_leaf) {
+                for (size_t j = 0; j < size; j++) {
+                    nodes[j] = this->node(nodes[j]->as_internal()->child(this->compare, keys[first + j]));
+                    prefetch(nodes[j]);
+                }
+            }
+
+            for (size_t j = 0; j < size; j++) {
+                results[first + j] = nodes[j]->as_leaf()->find(this->compare, keys[first + j]);
+            }
+        }
+    }
+
+#if __cplusplus >= 202002L
+    std::vector<V*> multi_search(std::span<const K> keys) {
+        std::vector<V*> results(keys.size());
+        this->multi_search(keys.data(), keys.size(), results.data());
+        return results;
+    }
+#endif
+
+    template <typename Lower, typename Upper>
+    std::vector<std::pair<K, V>> range_search(const Lower& lower_bound, const Upper& upper_bound) {
+        std::vector<std::pair<K, V>> result;
+        this->range_search(lower_bound, upper_bound, [&](const K& key, const V& value) {
+            result.emplace_back(key, value);
+        });
+        return result;
+    }
+
+    // pass the entries within [lower_bound, upper_bound] to visit(const K&, const V&) in key order,
+    // without copying them; a visit that returns false ends the scan
+    template <typename Lower, typename Upper, typename Visitor>
+    void range_search(const Lower& lower_bound, const Upper& upper_bound, Visitor&& visit) {
+        if (this->root == null_node) {
+            return;
+        }
+        const detail::probe_t<Compare, K, Lower>& lower = lower_bound;
+        const detail::probe_t<Compare, K, Upper>& upper = upper_bound;
+
+        // walk the leaf chain until a leaf ends past upper_bound
+        LeafNode* leaf = this->lower_leaf(lower);
+        while (leaf->range_search(this->compare, lower, upper, visit) && leaf->next != leaf_store::null_handle) {
+            leaf = this->leaves.get(leaf->next);
+        }
+    }
+
+    // combined Aggregate summary of the entries within [lower_bound, upper_bound]: the subtrees inside the
+    // range count through the summaries kept in their parents, so only the nodes on the paths to the two
+    // ends of the range are read. Values changed in place (through find() or an iterator) are not
+    // reflected in the summaries
+    template <typename Lower, typename Upper>
+    summary_type range_aggregate(const Lower& lower_bound, const Upper& upper_bound) const {
+        static_assert(aggregated, "range_aggregate needs an Aggregate policy");
+        const detail::probe_t<Compare, K, Lower>& lower = lower_bound;
+        const detail::probe_t<Compare, K, Upper>& upper = upper_bound;
+        if (this->root == null_node || this->compare(upper, lower)) {
+            return Aggregate::identity();
+        }
+        return this->aggregate_range(this->root, lower, upper, true, true);
+    }
+
+    // range_search() split at separators of the internal nodes into one chunk per thread, which scan
+    // their parts of the leaf chain concurrently (threads == 0 takes the hardware concurrency).
+    // Unordered, visit is called from all the threads at once, so it must be safe to call concurrently,
+    // and the entries arrive in key order only within a chunk. Ordered, visit is called from the calling
+    // thread in key order: it scans the first chunk itself while the others record the addresses of
+    // the entries of theirs, which it then visits in turn. A worker records at most ordered_batches
+    // batches of ordered_batch entries ahead of the calling thread (about 64 KB with 8-byte handles to
+    // key and value) and waits for it to take them, so an ordered scan needs memory for that per
+    // thread, not for the range. A visit that returns false stops every chunk, and so does one that
+    // throws: the exception reaches the caller once every thread has been joined (the one of the
+    // earliest chunk if several threw). Nothing may insert into the tree during the scan
+    template <typename Lower, typename Upper, typename Visitor>
+    void parallel_range_scan(const Lower& lower_bound, const Upper& upper_bound, Visitor&& visit, unsigned threads,
+                             bool ordered = false) {
+        const detail::probe_t<Compare, K, Lower>& lower = lower_bound;
+        const detail::probe_t<Compare, K, Upper>& upper = upper_bound;
+        if (this->root == null_node || this->compare(upper, lower)) {
+            return;
+        }
+        if (threads == 0) {
+            threads = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        std::vector<const K*> splits = this->split_keys(lower, upper, threads);
+        if (splits.empty()) {
+            this->range_search(lower_bound, upper_bound, visit);
+            return;
+        }
+
+        // chunk c runs from the split before it (or lower) to the split after it (excluded, or upper)
+        std::atomic<bool> stopped{false};
+        std::vector<ordered_chunk> chunks(ordered ? splits.size() + 1 : 0);
+        auto scan = [&](size_t c, auto& chunk_visit) {
+            if (c == 0) {
+                this->scan_chunk<false>(lower, *splits[0], chunk_visit);
+            } else if (c < splits.size()) {
+                this->scan_chunk<false>(*splits[c - 1], *splits[c], chunk_visit);
+            } else {
+                this->scan_chunk<true>(*splits[c - 1], upper, chunk_visit);
+            }
+        };
+        auto visit_until_stopped = [&](const K& key, const V& value) {
+            if (stopped.load(std::memory_order_relaxed)) {
+                return false;
+            } else if (!detail::visit_entry(visit, key, value)) {
+                stop_chunks(stopped, chunks);
+                return false;
+            }
+            return true;
+        };
+        auto scan_worker = [&](size_t c) {
+            if (ordered) {
+                std::vector<std::pair<const K*, const V*>> batch;
+                auto record = [&](const K& key, const V& value) {
+                    batch.emplace_back(&key, &value);
+                    if (batch.size() == ordered_batch) {
+                        bool pushed = chunks[c].push(std::move(batch), stopped);
+                        batch.clear();
+                        if (!pushed) {
+                            return false;
+                        }
+                    }
+                    return !stopped.load(std::memory_order_relaxed);
+                };
+                scan(c, record);
+                if (!batch.empty()) {
+                    chunks[c].push(std::move(batch), stopped);
+                }
+            } else {
+                scan(c, visit_until_stopped);
+            }
+        };
+
+#if defined(__cpp_exceptions) && !defined(TREES_NO_EXCEPTIONS)
+        // the exception a worker's chunk ended with, rethrown on the calling thread after the join
+        std::vector<std::exception_ptr> errors(splits.size() + 1);
+#endif
+        std::vector<std::thread> workers;
+        workers.reserve(splits.size());
+
+        // joins the workers still running when the scan ends by an exception, stopping them first
+        struct joiner {
+            std::vector<std::thread>& workers;
+            std::atomic<bool>& stopped;
+            std::vector<ordered_chunk>& chunks;
+
+            ~joiner() {
+                for (std::thread& worker : this->workers) {
+                    if (worker.joinable()) {
+                        stop_chunks(this->stopped, this->chunks);
+                        worker.join();
+                    }
+                }
+            }
+        } join_on_exit{workers, stopped, chunks};
+
+        for (size_t c = 1; c <= splits.size(); c++) {
+            workers.emplace_back([&, c] {
+#if defined(__cpp_exceptions) && !defined(TREES_NO_EXCEPTIONS)
+                try {
+                    scan_worker(c);
+                } catch (...) {
+                    errors[c] = std::current_exception();
+                    stop_chunks(stopped, chunks);
+                }
+#else
+                scan_worker(c);
+#endif
+                if (ordered) {
+                    chunks[c].finish();
+                }
+            });
+        }
+
+        scan(0, visit_until_stopped);
+        for (size_t c = 1; c <= splits.size(); c++) {
+            while (ordered && !stopped.load(std::memory_order_relaxed)) {
+                std::vector<std::pair<const K*, const V*>> batch = chunks[c].pop();
+                if (batch.empty()) {
+                    break;
+                }
+                for (const auto& [key, value] : batch) {
+                    if (!visit_until_stopped(*key, *value)) {
+                        break;
+                    }
+                }
+            }
+            workers[c - 1].join();
+#if defined(__cpp_exceptions) && !defined(TREES_NO_EXCEPTIONS)
+            if (errors[c]) {
+                std::rethrow_exception(errors[c]);
+            }
+#endif
+        }
+    }
+
+    // range_search() in descending key order, from upper_bound down to lower_bound along the prev links
+    // of the leaves, so the largest N entries of a range cost one descent and the leaves holding them
+    template <typename Upper, typename Lower, typename Visitor>
+    void reverse_range_search(const Upper& upper_bound, const Lower& lower_bound, Visitor&& visit) {
+        if (this->root == null_node) {
+            return;
+        }
+        const detail::probe_t<Compare, K, Lower>& lower = lower_bound;
+        const detail::probe_t<Compare, K, Upper>& upper = upper_bound;
+
+        // walk the leaf chain backwards until a leaf starts before lower_bound
+        LeafNode* leaf = this->find_leaf(upper);
+        while (leaf->reverse_range_search(this->compare, lower, upper, visit) && leaf->prev != leaf_store::null_handle) {
+            leaf = this->leaves.get(leaf->prev);
+        }
+    }
+
+    // bidirectional iterator over the entries in key order, one leaf slot at a time along the leaf chain.
+    // Keys and values live in separate arrays, so it dereferences to a pair of references
+    // (key, value) rather than to a stored pair. Inserting into the tree invalidates it
+    class iterator {
+        friend class BPlusTree;
+
+        const BPlusTree* tree = nullptr;
+        LeafNode* leaf = nullptr;
+        int index = 0;
+
+        iterator(const BPlusTree* tree, LeafNode* leaf, int index) : tree(tree), leaf(leaf), index(index) {
+            // a position past the last key of a leaf is the first key of the next one
+            if (this->leaf != nullptr && this->index == this->leaf->keys.size()) {
+                this->next_leaf();
+            }
+        }
+
+        void next_leaf() {
+            this->leaf = this->leaf->next == leaf_store::null_handle ? nullptr : this->tree->leaves.get(this->leaf->next);
+            this->index = 0;
+        }
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::pair<K, V>;
+        using reference = std::pair<const K&, V&>;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        const K& key() const { return this->leaf->key(this->index); }
+        V& value() const { return this->leaf->value(this->index); }
+        reference operator*() const { return reference(this->key(), this->value()); }
+
+        iterator& operator++() {
+            if (++this->index == this->leaf->keys.size()) {
+                this->next_leaf();
+            }
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        // decrementing end() gives the largest key; decrementing begin() is undefined
+        iterator& operator--() {
+            if (this->leaf == nullptr) {
+                this->leaf = this->tree->leaves.get(this->tree->last_leaf());
+            } else if (this->index > 0) {
+                this->index--;
+                return *this;
+            } else {
+                this->leaf = this->tree->leaves.get(this->leaf->prev);
+            }
+            this->index = this->leaf->keys.size() - 1;
+            return *this;
+        }
+
+        iterator operator--(int) {
+            iterator previous = *this;
+            --*this;
+            return previous;
+        }
+
+        bool operator==(const iterator& other) const { return this->leaf == other.leaf && this->index == other.index; }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+    };
+
+    iterator begin() {
+        if (this->root == null_node) {
+            return this->end();
+        }
+        return iterator(this, this->leaves.get(this->first_leaf()), 0);
+    }
+
+    iterator end() {
+        return iterator(this, nullptr, 0);
+    }
+
+    // entries in descending key order; (*it).first is the key
+    using reverse_iterator = std::reverse_iterator<iterator>;
+
+    reverse_iterator rbegin() {
+        return reverse_iterator(this->end());
+    }
+
+    reverse_iterator rend() {
+        return reverse_iterator(this->begin());
+    }
+
+    // first entry whose key is not smaller than key; a scan of [lower, upper] walks from
+    // lower_bound(lower) to upper_bound(upper) and reads only the leaves in between
+    template <typename Key>
+    iterator lower_bound(const Key& key) {
+        if (this->root == null_node) {
+            return this->end();
+        }
+        const detail::probe_t<Compare, K, Key>& probe = key;
+        LeafNode* leaf = this->lower_leaf(probe);
+        return iterator(this, leaf, detail::lower_rank<Search, k__slot>(leaf->keys, probe, this->compare));
+    }
+
+    // first entry whose key is greater than key
+    template <typename Key>
+    iterator upper_bound(const Key& key) {
+        if (this->root == null_node) {
+            return this->end();
+        }
+        const detail::probe_t<Compare, K, Key>& probe = key;
+        LeafNode* leaf = this->find_leaf(probe);
+        return iterator(this, leaf, detail::upper_rank<Search, k__slot>(leaf->keys, probe, this->compare));
+    }
+
+    // order statistics, for an Aggregate that counts its entries (CountAggregate, SummaryAggregate,
+    // KeySummaryAggregate):
+    // rank() and select() run one descent, adding up the counts of the children left of the path,
+    // and count() is range_aggregate()
+
+    // number of entries whose key is smaller than key
+    template <typename Key>
+    size_t rank(const Key& key) const {
+        static_assert(detail::counts_entries<Aggregate>, "rank needs an Aggregate with count()");
+        if (this->root == null_node) {
+            return 0;
+        }
+        const detail::probe_t<Compare, K, Key>& probe = key;
+        size_t result = 0;
+        Node* node = this->node(this->root);
+        while (!node->is_leaf) {
+            auto internal = node->as_internal();
+            int i = detail::lower_rank<Search, k__slot>(internal->keys, probe, this->compare);
+            for (int j = 0; j < i; j++) {
+                result += Aggregate::count(internal->summaries[j]);
+            }
+            node = this->node(internal->children[i]);
+        }
+        return result + detail::lower_rank<Search, k__slot>(node->as_leaf()->keys, probe, this->compare);
+    }
+
+    // the entry at index i in key order, or end() when there are not more than i entries
+    iterator select(size_t i) {
+        static_assert(detail::counts_entries<Aggregate>, "select needs an Aggregate with count()");
+        if (this->root == null_node) {
+            return this->end();
+        }
+        Node* node = this->node(this->root);
+        while (!node->is_leaf) {
+            auto internal = node->as_internal();
+            int j = 0;
+            for (; j < internal->children.size() - 1 && i >= Aggregate::count(internal->summaries[j]); j++) {
+                i -= Aggregate::count(internal->summaries[j]);
+            }
+            node = this->node(internal->children[j]);
+        }
+        LeafNode* leaf = node->as_leaf();
+        if (i >= leaf->keys.size()) {
+            return this->end();
+        }
+        return iterator(this, leaf, static_cast<int>(i));
+    }
+
+    // number of entries within [lower_bound, upper_bound]
+    template <typename Lower, typename Upper>
+    size_t count(const Lower& lower_bound, const Upper& upper_bound) const {
+        static_assert(detail::counts_entries<Aggregate>, "count needs an Aggregate with count()");
+        return Aggregate::count(this->range_aggregate(lower_bound, upper_bound));
+    }
+
+    // let find() (and contains(), try_get(), search()) go straight to the finger leaf when the key lies
+    // between its fences. That costs a lookup that misses the finger one or two key comparisons more,
+    // so it pays off only when lookups follow the recent inserts; off by default. Inserts use the
+    // finger either way
+    void enable_finger_lookups(bool enabled = true) {
+        this->finger_lookups = enabled;
+    }
+
+    // keep a Bloom filter of the keys (see key_filter.hpp) next to the tree, so that find() of an
+    // absent key usually returns without a descent; bits_per_key trades memory for false positives
+    // (about 1% at 10). Inserts add to it and rebuild it twice as large once it is full.
+    // The filter hashes keys with std::hash<K>, so keys that are equivalent under Compare must be equal
+    void enable_filter(int bits_per_key = 10) {
+        static_assert(detail::is_hashable<K>, "the key filter needs std::hash<K>");
+        this->rebuild_filter(bits_per_key);
+    }
+
+    // false when the filter rules key out, true otherwise (always without a filter, and for probes
+    // that do not hash like K)
+    template <typename Key>
+    bool may_contain(const Key& key) const {
+        if constexpr (detail::is_hash_probe<K, detail::probe_t<Compare, K, Key>>) {
+            const detail::probe_t<Compare, K, Key>& probe = key;
+            return !this->filter.enabled() || this->filter.may_contain(detail::key_hash<K>(probe));
+        } else {
+            return true;
+        }
+    }
+
+    // memory and expected false positive rate of the filter (all zero keys and bytes without one)
+    FilterStats filter_stats() const {
+        return this->filter.stats();
+    }
+
+    // read-optimized lookups for numeric keys ordered by operator<: a piecewise linear model of the
+    // first keys of the leaves (see learned_index.hpp) predicts the leaf of a key within max_error
+    // leaves, and find() searches around the prediction instead of descending the internal nodes.
+    // Leaves split off an indexed leaf are reached through a few steps along the leaf chain, or the
+    // descent when there are more of them (appends past the last indexed leaf), and inserts rebuild
+    // the model once those are an eighth of the indexed leaves
+    void build_learned_index(int max_error = 16) {
+        static_assert(std::is_arithmetic_v<K> && detail::is_plain_less<Compare, K>,
+                      "the learned index needs numeric keys ordered by operator<");
+        this->learned_error = std::max(max_error, 1);
+        this->rebuild_learned_index();
+    }
+
+    LearnedIndexStats learned_index_stats() const {
+        LearnedIndexStats stats{};
+        if constexpr (std::is_arithmetic_v<K>) {
+            stats.leaves = this->learned.size();
+            stats.segments = this->learned.segment_count();
+            stats.bytes = this->learned.bytes() + this->learned_leaves.capacity() * sizeof(leaf_handle);
+        }
+        stats.stale_splits = this->learned_splits;
+        stats.internal_bytes = this->root == null_node ? 0 : this->internal_bytes(this->root);
+        return stats;
+    }
+
+    // keep a hash index from the keys to their leaves next to the tree, so that find() of a key
+    // (and contains(), try_get(), search()) hashes it and searches its leaf without a descent, while
+    // range_search() still walks the tree. Inserts add to it and leaf splits update the keys they move.
+    // The index hashes keys with std::hash<K>, so keys that are equivalent under Compare must be equal
+    void enable_hash_index() {
+        static_assert(detail::is_hashable<K>, "the hash index needs std::hash<K>");
+        std::vector<std::pair<uint64_t, leaf_handle>> entries;
+        if (this->root != null_node) {
+            leaf_handle handle = this->first_leaf();
+            while (handle != leaf_store::null_handle) {
+                LeafNode* leaf = this->leaves.get(handle);
+                for (int i = 0; i < leaf->keys.size(); i++) {
+                    entries.emplace_back(detail::key_hash<K>(leaf->key(i)), handle);
+                }
+                handle = leaf->next;
+            }
+        }
+
+        this->hash_index.enable(entries.size());
+        for (const auto& [hash, leaf] : entries) {
+            this->hash_index.add(hash, leaf);
+        }
+    }
+
+    // entries and table size of the hash index (all zero without one)
+    HashIndexStats hash_index_stats() const {
+        return this->hash_index.stats();
+    }
+
+    void pretty_print() {
+        if (this->root != null_node) {
+            this->node(this->root)->pretty_print(*this);
+        }
+    }
+};
@@ -1,177 +1,760 @@
-#pragma once
-#include <iostream>
-#include <vector>
-#include <memory>
-
-template <
-    typename K,
-    typename V>
-class BTree {
-    using k__ptr = std::unique_ptr<K>;
-    using v__ptr = std::unique_ptr<V>;
-
-    struct Node {
-        int min_degree;
-        bool is_leaf;
-        std::vector<k__ptr> keys;
-        std::vector<v__ptr> values;
-        std::vector<std::unique_ptr<Node>> children;
-
-        Node(int min_degree, bool is_leaf) : min_degree(min_degree), is_leaf(is_leaf) {}
-
-        std::pair<std::pair<k__ptr, v__ptr>, std::unique_ptr<Node>> insert(k__ptr key, v__ptr value) {
-            // find the index to insert the key and value
-            int i = 0;
-            while (i < this->keys.size() && *key > *this->keys[i]) {
-                i++;
-            }
-
-            if (this->is_leaf) {
-                // CASE 1: node is a leaf
-                // insert <k, v> at the correct index
-                this->keys.insert(this->keys.begin() + i, std::move(key));
-                this->values.insert(this->values.begin() + i, std::move(value));
-            } else {
-                // CASE 2: node is not a leaf
-                // insert method is called recursively on the child node at index i
-                auto [median, new_child] = this->children[i]->insert(std::move(key), std::move(value));
-
-                // if the child node was split, insert the median <k, v> and the new child node at the correct index
-                if (new_child) {
-                    this->keys.insert(this->keys.begin() + i, std::move(median.first));
-                    this->values.insert(this->values.begin() + i, std::move(median.second));
-                    this->children.insert(this->children.begin() + i + 1, std::move(new_child));
-                }
-            }
-
-            // if the node is full (has more than 2 * min_degree - 1 keys), split it
-            if (this->keys.size() > 2 * this->min_degree - 1) {
-                auto median_key = std::move(this->keys[this->min_degree - 1]);
-                auto median_value = std::move(this->values[this->min_degree - 1]);
-                auto right_split = std::make_unique<Node>(this->min_degree, this->is_leaf);
-
-                for (int i = this->min_degree; i < this->keys.size(); i++) {
-                    right_split->keys.push_back(std::move(this->keys[i]));
-                    right_split->values.push_back(std::move(this->values[i]));
-                }
-                this->keys.erase(this->keys.begin() + this->min_degree - 1, this->keys.end());
-                this->values.erase(this->values.begin() + this->min_degree - 1, this->values.end());
-
-                // if the node is not a leaf, move the children to the right split node
-                if (!this->is_leaf) {
-                    for (int i = this->min_degree; i < this->children.size(); i++) {
-                        right_split->children.push_back(std::move(this->children[i]));
-                    }
-                    this->children.erase(this->children.begin() + this->min_degree, this->children.end());
-                }
-
-                // return the median <k, v> and the right split node to the parent node
-                return std::make_pair(std::make_pair(std::move(median_key), std::move(median_value)), std::move(right_split));
-            }
-            
-            // return nullptr if the node was not split
-            return std::make_pair(std::make_pair(nullptr, nullptr), nullptr);
-        }
-
-        V& search(K key) {
-            int i = 0;
-            while (i < this->keys.size() && key > *this->keys[i]) {
-                i++;
-            }
-
-            if (i < this->keys.size() && key == *this->keys[i]) {
-                return *this->values[i];
-            } else if (this->is_leaf) {
-                throw std::runtime_error("key not found");
-            } else {
-                return this->children[i]->search(key);
-            }
-        }
-
-        void range_search(K lower_bound, K upper_bound, std::vector<std::pair<K, V>>& result) {
-            int i = 0;
-            while (i < this->keys.size() && lower_bound > *this->keys[i]) {
-                i++;
-            }
-
-            if (this->is_leaf) {
-                while (i < this->keys.size() && upper_bound >= *this->keys[i]) {
-                    result.push_back(std::make_pair(*this->keys[i], *this->values[i]));
-                    i++;
-                }
-            } else {
-                while (i < this->keys.size() && upper_bound >= *this->keys[i]) {
-                    this->children[i]->range_search(lower_bound, upper_bound, result);
-                    result.push_back(std::make_pair(*this->keys[i], *this->values[i]));
-                    i++;
-                }
-                if (i < this->children.size()) {
-                    this->children[i]->range_search(lower_bound, upper_bound, result);
-                }
-            }
-        }
-
-        void pretty_print(int depth = 0) {
-            for (int i = 0; i < this->keys.size(); i++) {
-                if (!this->is_leaf) {
-                    this->children[i]->pretty_print(depth + 1);
-                }
-                for (int j = 0; j < depth; j++) {
-                    std::cout << "   ";
-                }
-                std::cout << *this->keys[i] << ": " << *this->values[i] << std::endl;
-            }
-            if (!this->is_leaf) {
-                this->children[this->keys.size()]->pretty_print(depth + 1);
-            }
-        }
-    };
-
-private:
-    std::unique_ptr<Node> root;
-    int min_degree;
-
-public:
-    BTree(int min_degree) : min_degree(min_degree), root(nullptr) {}
-
-    void insert(K key, V value) {
-        auto k = std::make_unique<K>(key);
-        auto v = std::make_unique<V>(value);
-
-        // if the tree is empty, create a new root node
-        if (this->root == nullptr) {
-            auto new_root = std::make_unique<Node>(this->min_degree, true);
-            new_root->keys.push_back(std::move(k));
-            new_root->values.push_back(std::move(v));
-
-            this->root = std::move(new_root);
-        } else {
-            // insert method is called on the root node to insert the key and value
-            auto [median, new_child] = this->root->insert(std::move(k), std::move(v));
-
-            // if the root node was split, create a new root node
-            if (new_child) {
-                auto new_root = std::make_unique<Node>(this->min_degree, false);
-                new_root->keys.push_back(std::move(median.first));
-                new_root->values.push_back(std::move(median.second));
-                new_root->children.push_back(std::move(this->root));
-                new_root->children.push_back(std::move(new_child));
-                this->root = std::move(new_root);
-            }
-        }
-    }
-
-    V& search(K key) {
-        return this->root->search(key);
-    }
-
-    std::vector<std::pair<K, V>> range_search(K lower_bound, K upper_bound) {
-        std::vector<std::pair<K, V>> result;
-        this->root->range_search(lower_bound, upper_bound, result);
-        return result;
-    }
-
-    void pretty_print() {
-        this->root->pretty_print();
-    }
-};
+#pragma once
+#include <cassert>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include <memory>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+#include "node_storage.hpp"
+#include "node_search.hpp"
+#include "node_allocator.hpp"
+#include "key_error.hpp"
+#include "aggregate.hpp"
+
+template <typename Tree>
+class InterleavedLookup;
+
+// MinDegree > 0 fixes the degree at compile time and gives every node inline key/value/child arrays;
+// MinDegree == 0 keeps the degree as a constructor argument with heap-allocated node vectors.
+// Nodes are allocated through Allocator (rebound to the node type), e.g. ArenaAllocator<char>,
+// or kept in a NodePool and linked through 32-bit handles. Allocator covers the nodes only: with a
+// runtime degree their key, value and child vectors still come from std::allocator, so an arena
+// saves allocations (and the teardown walk) only with a fixed MinDegree, whose arrays are inline.
+// Search is the key search policy inside a node: AdaptiveSearch, LinearSearch, BinarySearch or SimdSearch.
+// Keys are ordered by Compare; a transparent Compare such as std::less<> lets the lookups take probes
+// of other types (std::string_view, const char* for std::string keys) without converting them to K.
+// Aggregate (see aggregate.hpp), e.g. CountAggregate, keeps subtree summaries for range_aggregate()
+// and, when it counts entries, for rank(), select() and count()
+template <
+    typename K,
+    typename V,
+    int MinDegree = 0,
+    typename Allocator = std::allocator<char>,
+    typename Search = AdaptiveSearch,
+    typename Compare = std::less<K>,
+    typename Aggregate = NoAggregate>
+class BTree {
+    static_assert(MinDegree == 0 || MinDegree >= 2, "min degree must be at least 2");
+
+    using k__slot = detail::slot<K>;
+    using v__slot = detail::slot<V>;
+
+    // a node holds up to 2 * min_degree - 1 keys, plus one extra key before it is split
+    static constexpr int key_capacity = MinDegree > 0 ? 2 * MinDegree : 0;
+    static constexpr int child_capacity = MinDegree > 0 ? 2 * MinDegree + 1 : 0;
+
+    using key_array = detail::node_array<typename k__slot::type, key_capacity>;
+
+    static constexpr bool aggregated = !std::is_same_v<Aggregate, NoAggregate>;
+    using summary_type = typename detail::summary_of<Aggregate>::type;
+
+    struct Node;
+    using node_store = detail::node_store<Node, Allocator>;
+    using node_handle = typename node_store::handle;
+
+    struct Node {
+        bool is_leaf;
+        key_array keys;
+        detail::node_array<typename v__slot::type, key_capacity> values;
+        detail::node_array<node_handle, child_capacity> children;
+        // with an aggregate policy, the summary of each child subtree
+        std::conditional_t<aggregated, detail::node_array<summary_type, child_capacity>, char> summaries;
+
+        Node(bool is_leaf) : is_leaf(is_leaf) {}
+
+        K& key(int i) { return k__slot::get(this->keys[i]); }
+        V& value(int i) { return v__slot::get(this->values[i]); }
+
+        // move the keys, values and children after the median into right, and return the median <k, v>
+        std::pair<typename k__slot::type, typename v__slot::type> split(Node* right, int min_degree) {
+            auto median_key = std::move(this->keys[min_degree - 1]);
+            auto median_value = std::move(this->values[min_degree - 1]);
+
+            for (int i = min_degree; i < this->keys.size(); i++) {
+                right->keys.push_back(std::move(this->keys[i]));
+                right->values.push_back(std::move(this->values[i]));
+            }
+            this->keys.erase(this->keys.begin() + min_degree - 1, this->keys.end());
+            this->values.erase(this->values.begin() + min_degree - 1, this->values.end());
+
+            // if the node is not a leaf, move the children to the right split node
+            if (!this->is_leaf) {
+                for (int i = min_degree; i < this->children.size(); i++) {
+                    right->children.push_back(this->children[i]);
+                }
+                this->children.erase(this->children.begin() + min_degree, this->children.end());
+
+                if constexpr (aggregated) {
+                    for (int i = min_degree; i < this->summaries.size(); i++) {
+                        right->summaries.push_back(std::move(this->summaries[i]));
+                    }
+                    this->summaries.erase(this->summaries.begin() + min_degree, this->summaries.end());
+                }
+            }
+
+            return std::make_pair(std::move(median_key), std::move(median_value));
+        }
+
+        // value stored for key in this subtree, or nullptr
+        template <typename Key>
+        V* find(const node_store& nodes, const Compare& compare, const Key& key) {
+            // keys[i] is the first key not smaller than key
+            auto [i, equal] = detail::locate<Search, k__slot>(this->keys, key, compare);
+            if (equal) {
+                return &this->value(i);
+            } else if (this->is_leaf) {
+                return nullptr;
+            } else {
+                return nodes.get(this->children[i])->find(nodes, compare, key);
+            }
+        }
+
+        // pass the entries of this subtree within [lower_bound, upper_bound] to visit in key order;
+        // returns false once visit has asked to stop
+        template <typename Lower, typename Upper, typename Visitor>
+        bool range_search(const node_store& nodes, const Compare& compare, const Lower& lower_bound, const Upper& upper_bound,
+                          Visitor& visit) {
+            int i = detail::lower_rank<Search, k__slot>(this->keys, lower_bound, compare);
+
+            if (this->is_leaf) {
+                while (i < this->keys.size() && !compare(upper_bound, this->key(i))) {
+                    if (!detail::visit_entry(visit, this->key(i), this->value(i))) {
+                        return false;
+                    }
+                    i++;
+                }
+            } else {
+                while (i < this->keys.size() && !compare(upper_bound, this->key(i))) {
+                    if (!nodes.get(this->children[i])->range_search(nodes, compare, lower_bound, upper_bound, visit) ||
+                        !detail::visit_entry(visit, this->key(i), this->value(i))) {
+                        return false;
+                    }
+                    i++;
+                }
+                if (i < this->children.size()) {
+                    return nodes.get(this->children[i])->range_search(nodes, compare, lower_bound, upper_bound, visit);
+                }
+            }
+            return true;
+        }
+
+        // summary of the entries of this subtree
+        summary_type summarize() {
+            summary_type result = Aggregate::identity();
+            for (int i = 0; i < this->keys.size(); i++) {
+                if (!this->is_leaf) {
+                    result = Aggregate::combine(result, this->summaries[i]);
+                }
+                result = Aggregate::combine(result, Aggregate::lift(this->key(i), this->value(i)));
+            }
+            if (!this->is_leaf) {
+                result = Aggregate::combine(result, this->summaries[this->keys.size()]);
+            }
+            return result;
+        }
+
+        // summary of the entries of this subtree within [lower_bound, upper_bound]; a bound that is not
+        // checked is known to hold for the whole subtree. The keys of children[i] lie between keys i - 1
+        // and i, both included, so only the children at a checked bound are searched, the others inside
+        // the range count through their summaries
+        template <typename Lower, typename Upper>
+        summary_type aggregate_range(const node_store& nodes, const Compare& compare, const Lower& lower_bound,
+                                     const Upper& upper_bound, bool check_lower, bool check_upper) {
+            int first = check_lower ? detail::lower_rank<Search, k__slot>(this->keys, lower_bound, compare) : 0;
+            int last = check_upper ? detail::upper_rank<Search, k__slot>(this->keys, upper_bound, compare)
+                                   : this->keys.size();
+
+            summary_type result = Aggregate::identity();
+            for (int i = first; i <= last; i++) {
+                if (!this->is_leaf) {
+                    bool at_lower = check_lower && i == first;
+                    bool at_upper = check_upper && i == last;
+                    result = Aggregate::combine(result, at_lower || at_upper
+                        ? nodes.get(this->children[i])->aggregate_range(nodes, compare, lower_bound, upper_bound,
+                                                                        at_lower, at_upper)
+                        : this->summaries[i]);
+                }
+                if (i < last) {
+                    result = Aggregate::combine(result, Aggregate::lift(this->key(i), this->value(i)));
+                }
+            }
+            return result;
+        }
+
+        void pretty_print(const node_store& nodes, int depth = 0) {
+            for (int i = 0; i < this->keys.size(); i++) {
+                if (!this->is_leaf) {
+                    nodes.get(this->children[i])->pretty_print(nodes, depth + 1);
+                }
+                for (int j = 0; j < depth; j++) {
+                    std::cout << "   ";
+                }
+                std::cout << this->key(i) << ": " << this->value(i) << std::endl;
+            }
+            if (!this->is_leaf) {
+                nodes.get(this->children[this->keys.size()])->pretty_print(nodes, depth + 1);
+            }
+        }
+    };
+
+private:
+    // bound on the height of the tree, used to size the insertion path
+    static constexpr int max_height = 64;
+
+    // number of lookups multi_search keeps in flight
+    static constexpr size_t batch_group = 16;
+
+    node_handle root;
+    int min_degree;
+    node_store nodes;
+    Compare compare;
+
+    int degree() const {
+        if constexpr (MinDegree > 0) {
+            return MinDegree;
+        } else {
+            return this->min_degree;
+        }
+    }
+
+    // start loading the header and key array of a node, the part that a search reads;
+    // only the address is computed, so this does not wait for the node itself
+    static void prefetch(const Node* node) {
+        detail::prefetch(node, alignof(key_array) + sizeof(key_array));
+    }
+
+    // a lookup advanced one node at a time, for lookups that are interleaved with others
+    // (multi_search, InterleavedLookup): lookup_root() is the first node to search (nullptr when
+    // the tree is empty), and lookup_step() searches node for key and either finishes, setting
+    // result to the value or nullptr, or moves node to the child to search next and prefetches it
+    using lookup_cursor = Node*;
+
+    lookup_cursor lookup_root() const {
+        return this->root == node_store::null_handle ? nullptr : this->nodes.get(this->root);
+    }
+
+    bool lookup_step(lookup_cursor& node, const K& key, V*& result) {
+        if (node == nullptr) {
+            result = nullptr;
+            return true;
+        }
+
+        auto [i, equal] = detail::locate<Search, k__slot>(node->keys, key, this->compare);
+        if (equal) {
+            result = &node->value(i);
+            return true;
+        } else if (node->is_leaf) {
+            result = nullptr;
+            return true;
+        }
+
+        node = this->nodes.get(node->children[i]);
+        prefetch(node);
+        return false;
+    }
+
+    template <typename Tree>
+    friend class InterleavedLookup;
+
+    void destroy(node_handle handle) {
+        Node* node = this->nodes.get(handle);
+        if (!node->is_leaf) {
+            for (node_handle child : node->children) {
+                this->destroy(child);
+            }
+        }
+        this->nodes.destroy(handle);
+    }
+
+    void release() {
+        // an arena allocator releases trivially destructible nodes all at once
+        if constexpr (!node_store::bulk_release) {
+            if (this->root != node_store::null_handle) {
+                this->destroy(this->root);
+            }
+        }
+    }
+
+public:
+    // with a compile-time MinDegree the argument is only kept for compatibility and must match it
+    BTree(int min_degree, const Allocator& allocator = Allocator(), const Compare& compare = Compare())
+        : min_degree(min_degree), root(node_store::null_handle), nodes(allocator), compare(compare) {
+        assert(min_degree >= 2);
+        assert(MinDegree == 0 || min_degree == MinDegree);
+    }
+
+    // only a compile-time MinDegree can be left out, a runtime degree has no sensible default
+    template <int D = MinDegree, std::enable_if_t<(D > 0), int> = 0>
+    BTree() : BTree(MinDegree) {}
+
+    BTree(const BTree&) = delete;
+    BTree& operator=(const BTree&) = delete;
+
+    // the nodes move with the tree; the moved-from tree is left empty, with its degree and allocator
+    BTree(BTree&& other) noexcept
+        : min_degree(other.min_degree), root(std::exchange(other.root, node_store::null_handle)),
+          nodes(std::move(other.nodes)), compare(other.compare) {}
+
+    BTree& operator=(BTree&& other) noexcept {
+        if (this != &other) {
+            this->release();
+            this->root = std::exchange(other.root, node_store::null_handle);
+            this->min_degree = other.min_degree;
+            this->nodes = std::move(other.nodes);
+            this->compare = other.compare;
+        }
+        return *this;
+    }
+
+    ~BTree() {
+        this->release();
+    }
+
+    void insert(K key, V value) {
+        auto k = k__slot::make(std::move(key));
+        auto v = v__slot::make(std::move(value));
+
+        // if the tree is empty, create a new root node
+        if (this->root == node_store::null_handle) {
+            node_handle new_root = this->nodes.create(true);
+            this->nodes.get(new_root)->keys.push_back(std::move(k));
+            this->nodes.get(new_root)->values.push_back(std::move(v));
+
+            this->root = new_root;
+            return;
+        }
+
+        // descend to the leaf, remembering the path in case nodes have to be split
+        Node* path[max_height];
+        int path_index[max_height];
+        int depth = 0;
+
+        Node* node = this->nodes.get(this->root);
+        int i = detail::lower_rank<Search, k__slot>(node->keys, k__slot::get(k), this->compare);
+        while (!node->is_leaf) {
+            path[depth] = node;
+            path_index[depth] = i;
+            depth++;
+            node = this->nodes.get(node->children[i]);
+            i = detail::lower_rank<Search, k__slot>(node->keys, k__slot::get(k), this->compare);
+        }
+
+        // insert <k, v> at the correct index of the leaf
+        node->keys.insert(node->keys.begin() + i, std::move(k));
+        node->values.insert(node->values.begin() + i, std::move(v));
+
+        // summarize the subtrees on the path again from the bottom up, so that every summary combines
+        // its entries in key order
+        if constexpr (aggregated) {
+            for (int d = depth - 1; d >= 0; d--) {
+                path[d]->summaries[path_index[d]] = this->nodes.get(path[d]->children[path_index[d]])->summarize();
+            }
+        }
+
+        // while the node is full (has more than 2 * min_degree - 1 keys), split it and
+        // insert the median <k, v> and the right split node into the parent
+        int min_degree = this->degree();
+        while (static_cast<int>(node->keys.size()) > 2 * min_degree - 1) {
+            node_handle right_split = this->nodes.create(node->is_leaf);
+            auto [median_key, median_value] = node->split(this->nodes.get(right_split), min_degree);
+
+            // if the root node was split, create a new root node
+            if (depth == 0) {
+                node_handle new_root = this->nodes.create(false);
+                Node* root_node = this->nodes.get(new_root);
+                root_node->keys.push_back(std::move(median_key));
+                root_node->values.push_back(std::move(median_value));
+                root_node->children.push_back(this->root);
+                root_node->children.push_back(right_split);
+                if constexpr (aggregated) {
+                    root_node->summaries.push_back(node->summarize());
+                    root_node->summaries.push_back(this->nodes.get(right_split)->summarize());
+                }
+                this->root = new_root;
+                break;
+            }
+
+            depth--;
+            node = path[depth];
+            i = path_index[depth];
+            node->keys.insert(node->keys.begin() + i, std::move(median_key));
+            node->values.insert(node->values.begin() + i, std::move(median_value));
+            node->children.insert(node->children.begin() + i + 1, right_split);
+            if constexpr (aggregated) {
+                // the split child and its new right sibling each summarize their part of the entries
+                node->summaries[i] = this->nodes.get(node->children[i])->summarize();
+                node->summaries.insert(node->summaries.begin() + i + 1, this->nodes.get(right_split)->summarize());
+            }
+        }
+    }
+
+    // pointer to the value stored for key, or nullptr when the key is missing;
+    // a miss costs the same descent as a hit and never throws.
+    // The lookups take keys by reference: key is used as is with a transparent Compare, and is
+    // converted to K (once, not per node) otherwise
+    template <typename Key>
+    V* find(const Key& key) {
+        if (this->root == node_store::null_handle) {
+            return nullptr;
+        }
+        const detail::probe_t<Compare, K, Key>& probe = key;
+        return this->nodes.get(this->root)->find(this->nodes, this->compare, probe);
+    }
+
+    template <typename Key>
+    bool contains(const Key& key) {
+        return this->find(key) != nullptr;
+    }
+
+    // copy the value stored for key into value; returns false (leaving value untouched) on a miss
+    template <typename Key>
+    bool try_get(const Key& key, V& value) {
+        V* found = this->find(key);
+        if (found == nullptr) {
+            return false;
+        }
+        value = *found;
+        return true;
+    }
+
+    // throws std::runtime_error on a miss (see key_error.hpp)
+    template <typename Key>
+    V& search(const Key& key) {
+        V* found = this->find(key);
+        if (found == nullptr) {
+            detail::key_not_found("key not found");
+        }
+        return *found;
+    }
+
+    // find() for count keys at once, writing the results in input order: the lookups advance one
+    // level at a time in groups of batch_group, and every child is prefetched before the next
+    // lookup of the group is advanced, so the cache misses of the group overlap
+    void multi_search(const K* keys, size_t count, V** results) {
+        if (this->root == node_store::null_handle) {
+            std::fill(results, results + count, nullptr);
+            return;
+        }
+
+        lookup_cursor nodes[batch_group];
+        for (size_t first = 0; first < count; first += batch_group) {
+            size_t size = std::min(batch_group, count - first);
+            for (size_t j = 0; j < size; j++) {
+                nodes[j] = this->lookup_root();
+            }
+
+            // a lookup leaves the group when it finds its key or misses in a leaf
+            size_t active = size;
+            while (active > 0) {
+                for (size_t j = 0; j < size; j++) {
+                    if (nodes[j] != nullptr && this->lookup_step(nodes[j], keys[first + j], results[first + j])) {
+                        nodes[j] = nullptr;
+                        active--;
+                    }
+                }
+            }
+        }
+    }
+
+#if __cplusplus >= 202002L
+    std::vector<V*> multi_search(std::span<const K> keys) {
+        std::vector<V*> results(keys.size());
+        this->multi_search(keys.data(), keys.size(), results.data());
+        return results;
+    }
+#endif
+
+    template <typename Lower, typename Upper>
+    std::vector<std::pair<K, V>> range_search(const Lower& lower_bound, const Upper& upper_bound) {
+        std::vector<std::pair<K, V>> result;
+        this->range_search(lower_bound, upper_bound, [&](const K& key, const V& value) {
+            result.emplace_back(key, value);
+        });
+        return result;
+    }
+
+    // pass the entries within [lower_bound, upper_bound] to visit(const K&, const V&) in key order,
+    // without copying them; a visit that returns false ends the scan
+    template <typename Lower, typename Upper, typename Visitor>
+    void range_search(const Lower& lower_bound, const Upper& upper_bound, Visitor&& visit) {
+        if (this->root != node_store::null_handle) {
+            const detail::probe_t<Compare, K, Lower>& lower = lower_bound;
+            const detail::probe_t<Compare, K, Upper>& upper = upper_bound;
+            this->nodes.get(this->root)->range_search(this->nodes, this->compare, lower, upper, visit);
+        }
+    }
+
+    // in-order position in the tree, kept as the path from the root: every level holds a node and,
+    // for the ancestors, the index of the child the path descends into, for the last node the index
+    // of the current key (which can sit in an internal node). It holds at most max_height levels,
+    // so it does not allocate; inserts invalidate it
+    class iterator {
+        friend class BTree;
+
+        struct level {
+            Node* node;
+            int index;
+        };
+
+        const BTree* tree = nullptr;
+        level path[max_height];
+        int depth = 0; // 0 at the end
+
+        explicit iterator(const BTree* tree) : tree(tree) {}
+
+        Node* child(const level& top) const { return this->tree->nodes.get(top.node->children[top.index]); }
+
+        // extend the path to the smallest key of the subtree of node
+        void descend_first(Node* node) {
+            while (true) {
+                this->path[this->depth++] = level{node, 0};
+                if (node->is_leaf) {
+                    return;
+                }
+                node = this->tree->nodes.get(node->children[0]);
+            }
+        }
+
+        // extend the path to the largest key of the subtree of node
+        void descend_last(Node* node) {
+            while (!node->is_leaf) {
+                int last = node->keys.size();
+                this->path[this->depth++] = level{node, last};
+                node = this->tree->nodes.get(node->children[last]);
+            }
+            this->path[this->depth++] = level{node, static_cast<int>(node->keys.size()) - 1};
+        }
+
+        // a position past the last key of a node is the key that follows its subtree in the parent,
+        // or the end when there is none
+        void climb() {
+            while (this->depth > 0 && this->path[this->depth - 1].index == this->path[this->depth - 1].node->keys.size()) {
+                this->depth--;
+            }
+        }
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::pair<K, V>;
+        using reference = std::pair<const K&, V&>;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        const K& key() const { return this->path[this->depth - 1].node->key(this->path[this->depth - 1].index); }
+        V& value() const { return this->path[this->depth - 1].node->value(this->path[this->depth - 1].index); }
+        reference operator*() const { return reference(this->key(), this->value()); }
+
+        iterator& operator++() {
+            level& top = this->path[this->depth - 1];
+            top.index++;
+            if (top.node->is_leaf) {
+                this->climb();
+            } else {
+                // the next key is the smallest of the subtree right of the current one
+                this->descend_first(this->child(top));
+            }
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        // decrementing end() gives the largest key; decrementing begin() is undefined
+        iterator& operator--() {
+            if (this->depth == 0) {
+                this->descend_last(this->tree->nodes.get(this->tree->root));
+                return *this;
+            }
+
+            level& top = this->path[this->depth - 1];
+            if (!top.node->is_leaf) {
+                // the previous key is the largest of the subtree left of the current one
+                this->descend_last(this->child(top));
+            } else if (top.index > 0) {
+                top.index--;
+            } else {
+                // climb out of the subtrees the path entered through their first child
+                do {
+                    this->depth--;
+                } while (this->path[this->depth - 1].index == 0);
+                this->path[this->depth - 1].index--;
+            }
+            return *this;
+        }
+
+        iterator operator--(int) {
+            iterator previous = *this;
+            --*this;
+            return previous;
+        }
+
+        bool operator==(const iterator& other) const {
+            if (this->depth != other.depth) {
+                return false;
+            }
+            return this->depth == 0 || (this->path[this->depth - 1].node == other.path[this->depth - 1].node &&
+                                        this->path[this->depth - 1].index == other.path[this->depth - 1].index);
+        }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+    };
+
+    iterator begin() {
+        iterator it(this);
+        if (this->root != node_store::null_handle) {
+            it.descend_first(this->nodes.get(this->root));
+        }
+        return it;
+    }
+
+    iterator end() {
+        return iterator(this);
+    }
+
+    // entries in descending key order; (*it).first is the key
+    using reverse_iterator = std::reverse_iterator<iterator>;
+
+    reverse_iterator rbegin() {
+        return reverse_iterator(this->end());
+    }
+
+    reverse_iterator rend() {
+        return reverse_iterator(this->begin());
+    }
+
+    // first entry whose key is not smaller than key; the descent goes down to a leaf even past an
+    // internal node holding key, since inserts place equal keys in the subtree left of it
+    template <typename Key>
+    iterator lower_bound(const Key& key) {
+        iterator it(this);
+        if (this->root == node_store::null_handle) {
+            return it;
+        }
+        const detail::probe_t<Compare, K, Key>& probe = key;
+        Node* node = this->nodes.get(this->root);
+        while (true) {
+            int i = detail::lower_rank<Search, k__slot>(node->keys, probe, this->compare);
+            it.path[it.depth++] = typename iterator::level{node, i};
+            if (node->is_leaf) {
+                break;
+            }
+            node = this->nodes.get(node->children[i]);
+        }
+        it.climb();
+        return it;
+    }
+
+    // first entry whose key is greater than key
+    template <typename Key>
+    iterator upper_bound(const Key& key) {
+        iterator it(this);
+        if (this->root == node_store::null_handle) {
+            return it;
+        }
+        const detail::probe_t<Compare, K, Key>& probe = key;
+        Node* node = this->nodes.get(this->root);
+        while (true) {
+            int i = detail::upper_rank<Search, k__slot>(node->keys, probe, this->compare);
+            it.path[it.depth++] = typename iterator::level{node, i};
+            if (node->is_leaf) {
+                break;
+            }
+            node = this->nodes.get(node->children[i]);
+        }
+        it.climb();
+        return it;
+    }
+
+    // combined Aggregate summary of the entries within [lower_bound, upper_bound]: the subtrees inside the
+    // range count through the summaries kept in their parents, so only the nodes on the paths to the two
+    // ends of the range are read. Values changed in place (through find() or an iterator) are not
+    // reflected in the summaries
+    template <typename Lower, typename Upper>
+    summary_type range_aggregate(const Lower& lower_bound, const Upper& upper_bound) const {
+        static_assert(aggregated, "range_aggregate needs an Aggregate policy");
+        const detail::probe_t<Compare, K, Lower>& lower = lower_bound;
+        const detail::probe_t<Compare, K, Upper>& upper = upper_bound;
+        if (this->root == node_store::null_handle || this->compare(upper, lower)) {
+            return Aggregate::identity();
+        }
+        return this->nodes.get(this->root)->aggregate_range(this->nodes, this->compare, lower, upper, true, true);
+    }
+
+    // order statistics, for an Aggregate that counts its entries (CountAggregate, SummaryAggregate,
+    // KeySummaryAggregate):
+    // rank() and select() run one descent, adding up the counts of the children and keys left of
+    // the path, and count() is range_aggregate()
+
+    // number of entries whose key is smaller than key
+    template <typename Key>
+    size_t rank(const Key& key) const {
+        static_assert(detail::counts_entries<Aggregate>, "rank needs an Aggregate with count()");
+        if (this->root == node_store::null_handle) {
+            return 0;
+        }
+        const detail::probe_t<Compare, K, Key>& probe = key;
+        size_t result = 0;
+        Node* node = this->nodes.get(this->root);
+        while (true) {
+            int i = detail::lower_rank<Search, k__slot>(node->keys, probe, this->compare);
+            result += i;
+            if (node->is_leaf) {
+                return result;
+            }
+            for (int j = 0; j < i; j++) {
+                result += Aggregate::count(node->summaries[j]);
+            }
+            node = this->nodes.get(node->children[i]);
+        }
+    }
+
+    // the entry at index i in key order, or end() when there are not more than i entries
+    iterator select(size_t i) {
+        static_assert(detail::counts_entries<Aggregate>, "select needs an Aggregate with count()");
+        iterator it(this);
+        if (this->root == node_store::null_handle) {
+            return it;
+        }
+        Node* node = this->nodes.get(this->root);
+        while (!node->is_leaf) {
+            // skip the children and keys before entry i
+            int j = 0;
+            for (; j < node->keys.size(); j++) {
+                size_t count = Aggregate::count(node->summaries[j]);
+                if (i < count) {
+                    break;
+                } else if (i == count) {
+                    it.path[it.depth++] = typename iterator::level{node, j};
+                    return it;
+                }
+                i -= count + 1;
+            }
+            it.path[it.depth++] = typename iterator::level{node, j};
+            node = this->nodes.get(node->children[j]);
+        }
+        if (i >= node->keys.size()) {
+            return this->end();
+        }
+        it.path[it.depth++] = typename iterator::level{node, static_cast<int>(i)};
+        return it;
+    }
+
+    // number of entries within [lower_bound, upper_bound]
+    template <typename Lower, typename Upper>
+    size_t count(const Lower& lower_bound, const Upper& upper_bound) const {
+        static_assert(detail::counts_entries<Aggregate>, "count needs an Aggregate with count()");
+        return Aggregate::count(this->range_aggregate(lower_bound, upper_bound));
+    }
+
+    void pretty_print() {
+        if (this->root != node_store::null_handle) {
+            this->nodes.get(this->root)->pretty_print(this->nodes);
+        }
+    }
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// memory of a tree's hash index
+struct HashIndexStats {
+    size_t entries; // keys indexed
+    size_t slots;   // capacity of the table
+    size_t bytes;   // size of the table
+};
+
+// open-addressing hash table from key hashes to the leaves holding the keys, for exact-match lookups
+// that skip the descent. Keys are not stored: a lookup searches the leaf of every entry with the same
+// hash, and duplicate keys have one entry each. Linear probing over a power-of-two table, grown to
+// twice the size once it is three quarters full
+template <typename Handle>
+class HashIndex {
+    struct entry {
+        uint64_t hash;
+        Handle leaf;
+    };
+
+    std::vector<entry> slots;
+    size_t count = 0;
+    Handle null;
+
+    size_t mask() const { return this->slots.size() - 1; }
+
+    void place(uint64_t hash, Handle leaf) {
+        size_t i = hash & this->mask();
+        while (this->slots[i].leaf != this->null) {
+            i = (i + 1) & this->mask();
+        }
+        this->slots[i] = entry{hash, leaf};
+    }
+
+    void grow() {
+        std::vector<entry> old(std::max<size_t>(2 * this->slots.size(), 1024), entry{0, this->null});
+        old.swap(this->slots);
+        for (const entry& e : old) {
+            if (e.leaf != this->null) {
+                this->place(e.hash, e.leaf);
+            }
+        }
+    }
+
+public:
+    // null is the handle value that marks an empty slot; the index starts disabled
+    explicit HashIndex(Handle null) : null(null) {}
+
+    bool enabled() const { return !this->slots.empty(); }
+
+    // start indexing, with room for capacity keys before the table grows
+    void enable(size_t capacity) {
+        size_t size = 1024;
+        while (size / 4 * 3 < capacity) {
+            size *= 2;
+        }
+        this->slots.assign(size, entry{0, this->null});
+        this->count = 0;
+    }
+
+    void add(uint64_t hash, Handle leaf) {
+        if (this->count + 1 > this->slots.size() / 4 * 3) {
+            this->grow();
+        }
+        this->place(hash, leaf);
+        this->count++;
+    }
+
+    // one key with this hash moved from leaf from to leaf to (a leaf split)
+    void move(uint64_t hash, Handle from, Handle to) {
+        size_t i = hash & this->mask();
+        while (this->slots[i].leaf != this->null) {
+            if (this->slots[i].hash == hash && this->slots[i].leaf == from) {
+                this->slots[i].leaf = to;
+                return;
+            }
+            i = (i + 1) & this->mask();
+        }
+    }
+
+    // lookup(leaf) for the leaf of each entry with this hash, until one returns a value pointer;
+    // nullptr when none does. A miss stops at the first empty slot without touching any leaf
+    template <typename T, typename Lookup>
+    T* find(uint64_t hash, Lookup&& lookup) const {
+        size_t i = hash & this->mask();
+        while (this->slots[i].leaf != this->null) {
+            if (this->slots[i].hash == hash) {
+                if (T* found = lookup(this->slots[i].leaf)) {
+                    return found;
+                }
+            }
+            i = (i + 1) & this->mask();
+        }
+        return nullptr;
+    }
+
+    HashIndexStats stats() const {
+        return HashIndexStats{this->count, this->slots.size(), this->slots.capacity() * sizeof(entry)};
+    }
+};
@@ -0,0 +1,98 @@
+#pragma once
+#if __cplusplus < 202002L
+#error "interleaved_lookup.hpp needs C++20 coroutines (-std=c++20)"
+#endif
+#include <algorithm>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+#include <vector>
+
+namespace detail {
+    // owner of a lookup coroutine; it starts suspended and stays suspended at its end,
+    // so the scheduler decides when it runs and when its frame is released
+    class lookup_task {
+    public:
+        struct promise_type {
+            lookup_task get_return_object() {
+                return lookup_task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        explicit lookup_task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+        lookup_task(lookup_task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+        lookup_task(const lookup_task&) = delete;
+        lookup_task& operator=(const lookup_task&) = delete;
+
+        ~lookup_task() {
+            if (this->handle) {
+                this->handle.destroy();
+            }
+        }
+
+        bool done() const { return this->handle.done(); }
+        void resume() { this->handle.resume(); }
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+    };
+}
+
+// lookup engine that interleaves a batch of lookups on one thread with coroutines: a lookup
+// prefetches the next node it has to search and suspends, and a round-robin scheduler resumes
+// the other in-flight lookups while that node is loaded from memory. Works over the nodes of
+// BTree and BPlusTree through their lookup_root() / lookup_step()
+template <typename Tree>
+class InterleavedLookup {
+    using cursor = typename Tree::lookup_cursor;
+
+    Tree& tree;
+    size_t width;
+
+    // one in-flight lookup at a time: takes the next key of the batch until none is left,
+    // so a batch needs only width coroutine frames
+    template <typename K, typename V>
+    detail::lookup_task lane(const K* keys, size_t count, V** results, size_t& next) {
+        while (next < count) {
+            size_t i = next++;
+            cursor node = this->tree.lookup_root();
+            while (!this->tree.lookup_step(node, keys[i], results[i])) {
+                co_await std::suspend_always{};
+            }
+        }
+    }
+
+public:
+    // width is the number of lookups kept in flight
+    explicit InterleavedLookup(Tree& tree, size_t width = 16) : tree(tree), width(std::max<size_t>(width, 1)) {}
+
+    // find() for count keys, writing the value pointers (nullptr for a miss) in input order
+    template <typename K, typename V>
+    void run(const K* keys, size_t count, V** results) {
+        size_t next = 0;
+        std::vector<detail::lookup_task> lanes;
+        lanes.reserve(std::min(this->width, count));
+        for (size_t j = 0; j < std::min(this->width, count); j++) {
+            lanes.push_back(this->lane(keys, count, results, next));
+        }
+
+        // resume the lanes in turn until every one has run out of keys
+        size_t active = lanes.size();
+        while (active > 0) {
+            for (auto& lane : lanes) {
+                if (!lane.done()) {
+                    lane.resume();
+                    if (lane.done()) {
+                        active--;
+                    }
+                }
+            }
+        }
+    }
+};
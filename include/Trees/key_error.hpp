@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace detail {
+    // search() reports a missing key with std::runtime_error; when the headers are built with
+    // -fno-exceptions (or TREES_NO_EXCEPTIONS is defined) it prints the message and aborts instead.
+    // Lookups that may miss should use find() / contains() / try_get(), which never throw
+    [[noreturn]] inline void key_not_found(const char* message) {
+#if defined(__cpp_exceptions) && !defined(TREES_NO_EXCEPTIONS)
+        throw std::runtime_error(message);
+#else
+        std::fprintf(stderr, "%s\n", message);
+        std::abort();
+#endif
+    }
+}
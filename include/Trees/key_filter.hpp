@@ -0,0 +1,101 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "key_hash.hpp"
+
+// memory and accuracy of a tree's key filter
+struct FilterStats {
+    size_t keys;                // keys added since the filter was last built
+    size_t bytes;               // size of the bit array
+    double bits_per_key;        // bits per key added so far
+    double false_positive_rate; // expected share of absent keys that still pass the filter
+};
+
+// blocked Bloom filter over key hashes: a key sets and tests all of its bits within one 64-byte
+// block, so a test reads a single cache line. Sized for a number of keys (capacity); beyond it
+// the false positive rate climbs, and the owner rebuilds it larger
+class KeyFilter {
+    static constexpr int block_bits = 512;
+
+    struct alignas(64) block {
+        uint64_t words[block_bits / 64];
+    };
+
+    std::vector<block> blocks;
+    size_t count = 0;
+    size_t capacity = 0;
+    int bits = 0;
+    int probes = 0;
+
+    // the upper half of the hash picks the block (multiply-shift instead of a modulo)
+    size_t block_index(uint64_t hash) const {
+        return ((hash >> 32) * this->blocks.size()) >> 32;
+    }
+
+    // bit of the i-th probe within the block, from the lower half of the hash
+    static int bit_of(uint64_t hash, int i) {
+        uint32_t first = static_cast<uint32_t>(hash);
+        uint32_t step = (static_cast<uint32_t>(hash >> 32) * 0x9e3779b9u) | 1;
+        return static_cast<int>((first + i * step) >> 23);
+    }
+
+public:
+    // empty filter, which is disabled
+    KeyFilter() = default;
+
+    // about bits_per_key bits for each of capacity keys, with the number of probes that minimizes
+    // the false positive rate (bits_per_key * ln 2): roughly 1% at 10 bits per key
+    KeyFilter(size_t capacity, int bits_per_key)
+        : blocks((std::max<size_t>(capacity, 1) * std::max(bits_per_key, 1) + block_bits - 1) / block_bits, block{}),
+          capacity(capacity),
+          bits(bits_per_key),
+          probes(std::clamp(static_cast<int>(std::lround(bits_per_key * 0.693)), 1, 16)) {}
+
+    bool enabled() const { return !this->blocks.empty(); }
+    bool full() const { return this->count >= this->capacity; }
+    int bits_per_key() const { return this->bits; }
+
+    void add(uint64_t hash) {
+        block& b = this->blocks[this->block_index(hash)];
+        for (int i = 0; i < this->probes; i++) {
+            int bit = bit_of(hash, i);
+            b.words[bit >> 6] |= uint64_t(1) << (bit & 63);
+        }
+        this->count++;
+    }
+
+    // false only when no key with this hash was added
+    bool may_contain(uint64_t hash) const {
+        const block& b = this->blocks[this->block_index(hash)];
+        bool found = true;
+        for (int i = 0; i < this->probes; i++) {
+            int bit = bit_of(hash, i);
+            found &= (b.words[bit >> 6] >> (bit & 63)) & 1;
+        }
+        return found;
+    }
+
+    // the expected false positive rate averages, over the blocks an absent key can hash to,
+    // the chance that all of its probes hit bits that are already set
+    FilterStats stats() const {
+        double rate = 0;
+        for (const block& b : this->blocks) {
+            int set = 0;
+            for (uint64_t word : b.words) {
+                set += __builtin_popcountll(word);
+            }
+            rate += std::pow(double(set) / block_bits, this->probes);
+        }
+
+        size_t bytes = this->blocks.size() * sizeof(block);
+        return FilterStats{
+            this->count,
+            bytes,
+            this->count > 0 ? 8.0 * bytes / this->count : 0.0,
+            this->blocks.empty() ? 1.0 : rate / this->blocks.size(),
+        };
+    }
+};
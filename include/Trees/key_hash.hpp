@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace detail {
+    template <typename T, typename = void>
+    inline constexpr bool is_hashable = false;
+
+    template <typename T>
+    inline constexpr bool is_hashable<T, std::void_t<decltype(std::hash<T>()(std::declval<const T&>()))>> = true;
+
+    // probes that hash like the key they are equal to: K itself, and for std::string keys anything
+    // that converts to std::string_view, whose std::hash is the one of std::string
+    template <typename K, typename Key>
+    inline constexpr bool is_hash_probe = is_hashable<K> &&
+        (std::is_same_v<K, Key> || (std::is_same_v<K, std::string> && std::is_convertible_v<const Key&, std::string_view>));
+
+    // 64-bit hash of a key of type K, or of a probe for one (is_hash_probe)
+    template <typename K, typename Key>
+    uint64_t key_hash(const Key& key) {
+        uint64_t hash;
+        if constexpr (std::is_same_v<K, Key>) {
+            hash = std::hash<K>()(key);
+        } else {
+            hash = std::hash<std::string_view>()(std::string_view(key));
+        }
+
+        // std::hash of an integer is the integer itself in the common standard libraries,
+        // so spread the bits (murmur3 finalizer)
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// memory and freshness of a tree's learned index
+struct LearnedIndexStats {
+    size_t leaves;         // leaves indexed when the model was built
+    size_t segments;       // linear pieces of the model
+    size_t bytes;          // model, first keys and leaf table
+    size_t stale_splits;   // leaf splits since the model was built
+    size_t internal_bytes; // internal nodes, the index of the standard descent
+};
+
+// piecewise linear model of a sorted array of numeric keys, in the style of a one-level PGM index:
+// the array is cut into segments, each a line that predicts the positions of its keys within
+// max_error, found in one pass with the shrinking cone algorithm. A lookup binary searches the
+// first keys of the segments, evaluates the line and searches the keys around the prediction
+template <typename K>
+class LearnedIndex {
+    static_assert(std::is_arithmetic_v<K>, "the learned index models numeric keys");
+
+    struct segment {
+        K first;
+        double slope;
+        int position;
+    };
+
+    std::vector<K> keys;
+    std::vector<segment> segments;
+    int max_error = 0;
+
+    // first position of the segment after s, the end of the positions s predicts
+    int segment_end(const segment* s) const {
+        return s + 1 < this->segments.data() + this->segments.size() ? s[1].position : static_cast<int>(this->keys.size());
+    }
+
+public:
+    LearnedIndex() = default;
+
+    LearnedIndex(std::vector<K> keys, int max_error) : keys(std::move(keys)), max_error(std::max(max_error, 1)) {
+        int n = static_cast<int>(this->keys.size());
+        int i = 0;
+        while (i < n) {
+            // slopes of the lines through the first key that keep every key so far within max_error
+            segment s{this->keys[i], 0.0, i};
+            double low = 0.0;
+            double high = std::numeric_limits<double>::infinity();
+
+            int j = i + 1;
+            for (; j < n; j++) {
+                double dx = double(this->keys[j]) - double(s.first);
+                double dy = j - i;
+                if (dx == 0) {
+                    if (dy > this->max_error) {
+                        break;
+                    }
+                    continue;
+                }
+                double slope_low = (dy - this->max_error) / dx;
+                double slope_high = (dy + this->max_error) / dx;
+                if (slope_low > high || slope_high < low) {
+                    break;
+                }
+                low = std::max(low, slope_low);
+                high = std::min(high, slope_high);
+            }
+
+            s.slope = high == std::numeric_limits<double>::infinity() ? low : (low + high) / 2;
+            this->segments.push_back(s);
+            i = j;
+        }
+    }
+
+    bool empty() const { return this->keys.empty(); }
+    size_t size() const { return this->keys.size(); }
+    size_t segment_count() const { return this->segments.size(); }
+
+    size_t bytes() const {
+        return this->keys.capacity() * sizeof(K) + this->segments.capacity() * sizeof(segment);
+    }
+
+    // index of the last key not greater than key, 0 when every key is greater; the index must not be empty
+    int rank(K key) const {
+        auto s = std::upper_bound(this->segments.begin(), this->segments.end(), key,
+            [](K key, const segment& s) { return key < s.first; });
+        const segment* line = s == this->segments.begin() ? &this->segments[0] : &s[-1];
+
+        double predicted = line->position + line->slope * (double(key) - double(line->first));
+        int end = this->segment_end(line);
+        int position = static_cast<int>(std::clamp(predicted, double(line->position), double(end)));
+
+        // search max_error positions (plus one for rounding) around the prediction; keys between two
+        // modelled positions can be predicted a position further, and only then is the search widened
+        int n = static_cast<int>(this->keys.size());
+        int first = std::max(position - this->max_error - 1, 0);
+        int last = std::min(position + this->max_error + 2, n);
+        auto begin = this->keys.begin();
+        int i = static_cast<int>(std::upper_bound(begin + first, begin + last, key) - begin);
+        if (i == first && first > 0) {
+            i = static_cast<int>(std::upper_bound(begin, begin + first, key) - begin);
+        } else if (i == last && last < n) {
+            i = static_cast<int>(std::upper_bound(begin + last, this->keys.end(), key) - begin);
+        }
+        return std::max(i - 1, 0);
+    }
+};
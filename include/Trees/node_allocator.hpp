@@ -0,0 +1,244 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// bump allocator that hands out blocks from large chunks; blocks are never returned one by one,
+// all chunks are released together when the arena is destroyed
+class Arena {
+    struct ChunkDeleter {
+        void operator()(std::byte* chunk) const {
+            ::operator delete(chunk, std::align_val_t(alignof(std::max_align_t)));
+        }
+    };
+
+    std::vector<std::unique_ptr<std::byte, ChunkDeleter>> chunks;
+    void* cursor = nullptr;
+    size_t remaining = 0;
+    size_t chunk_size;
+    size_t reserved = 0;
+
+public:
+    explicit Arena(size_t chunk_size = 1 << 20) : chunk_size(chunk_size) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment) {
+        if (std::align(alignment, size, this->cursor, this->remaining) == nullptr) {
+            // the current chunk is exhausted, start a new one (oversized requests get their own chunk)
+            size_t bytes = std::max(this->chunk_size, size + alignment);
+            auto chunk = static_cast<std::byte*>(::operator new(bytes, std::align_val_t(alignof(std::max_align_t))));
+            this->chunks.emplace_back(chunk);
+            this->cursor = chunk;
+            this->remaining = bytes;
+            this->reserved += bytes;
+            std::align(alignment, size, this->cursor, this->remaining);
+        }
+
+        void* block = this->cursor;
+        this->cursor = static_cast<std::byte*>(this->cursor) + size;
+        this->remaining -= size;
+        return block;
+    }
+
+    // total bytes taken from the system
+    size_t bytes_reserved() const {
+        return this->reserved;
+    }
+};
+
+// std-compatible allocator over a shared Arena; deallocate is a no-op, so a tree built on it
+// is released in one go when the last copy of the allocator (and with it the arena) goes away
+template <typename T>
+class ArenaAllocator {
+    template <typename U>
+    friend class ArenaAllocator;
+
+    std::shared_ptr<Arena> arena;
+
+public:
+    using value_type = T;
+
+    ArenaAllocator() : arena(std::make_shared<Arena>()) {}
+    explicit ArenaAllocator(std::shared_ptr<Arena> arena) : arena(std::move(arena)) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(this->arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) {}
+
+    const std::shared_ptr<Arena>& resource() const {
+        return this->arena;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return this->arena == other.arena;
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const {
+        return this->arena != other.arena;
+    }
+};
+
+// selects the node pool mode when given as the Allocator of a tree: nodes live in per-type pools
+// and link to each other through 32-bit indices instead of 64-bit pointers
+struct NodePool {};
+
+namespace detail {
+    // allocators whose memory is reclaimed as a whole, without per-node deallocation
+    template <typename Allocator>
+    inline constexpr bool releases_all = false;
+
+    template <typename T>
+    inline constexpr bool releases_all<ArenaAllocator<T>> = true;
+
+    // creates and destroys the nodes of a tree through the tree's Allocator, rebound to Node
+    template <typename Node, typename Allocator>
+    class node_store {
+        using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+        using traits = std::allocator_traits<allocator_type>;
+
+        allocator_type allocator;
+
+    public:
+        using handle = Node*;
+
+        // the tree can skip walking its nodes on destruction when the allocator frees everything
+        // at once and the nodes own nothing outside of it
+        static constexpr bool bulk_release = releases_all<allocator_type> && std::is_trivially_destructible_v<Node>;
+
+        static constexpr handle null_handle = nullptr;
+
+        explicit node_store(const Allocator& allocator) : allocator(allocator) {}
+
+        // the nodes belong to the tree, only the allocator is taken over; it is copied, so the
+        // moved-from store can still create nodes
+        node_store(node_store&& other) noexcept : allocator(other.allocator) {}
+
+        node_store& operator=(node_store&& other) noexcept {
+            this->allocator = other.allocator;
+            return *this;
+        }
+
+        template <typename... Args>
+        handle create(Args&&... args) {
+            Node* node = std::addressof(*traits::allocate(this->allocator, 1));
+            traits::construct(this->allocator, node, std::forward<Args>(args)...);
+            return node;
+        }
+
+        void destroy(handle node) {
+            traits::destroy(this->allocator, node);
+            traits::deallocate(this->allocator, node, 1);
+        }
+
+        Node* get(handle node) const {
+            return node;
+        }
+    };
+
+    template <typename Allocator>
+    inline constexpr bool is_node_pool = std::is_same_v<Allocator, NodePool>;
+
+    // number of index bits addressing a node inside one pool chunk, so that chunks are about 1 MiB
+    constexpr int pool_chunk_bits(size_t node_size) {
+        int bits = 0;
+        while ((size_t(2) << bits) * node_size <= (size_t(1) << 20)) {
+            bits++;
+        }
+        return bits;
+    }
+
+    // node pool: nodes are placed in fixed-size chunks and addressed by a 32-bit index,
+    // chunk = index >> chunk_bits, slot = index & chunk_mask; nodes stay at a fixed address
+    template <typename Node>
+    class node_store<Node, NodePool> {
+        static constexpr int chunk_bits = pool_chunk_bits(sizeof(Node));
+        static constexpr uint32_t chunk_mask = (uint32_t(1) << chunk_bits) - 1;
+
+        struct ChunkDeleter {
+            void operator()(Node* chunk) const {
+                ::operator delete(chunk, std::align_val_t(alignof(Node)));
+            }
+        };
+
+        std::vector<std::unique_ptr<Node, ChunkDeleter>> chunks;
+        uint32_t count = 0;
+
+    public:
+        using handle = uint32_t;
+
+        // the pool destroys its nodes itself, the tree never has to walk them
+        static constexpr bool bulk_release = true;
+
+        // the top bit is left free, trees may use it to tag handles
+        static constexpr handle null_handle = UINT32_MAX;
+        static constexpr handle max_handle = UINT32_MAX >> 1;
+
+        explicit node_store(const NodePool&) {}
+
+        node_store(const node_store&) = delete;
+        node_store& operator=(const node_store&) = delete;
+
+        // the nodes move with the chunks, the moved-from pool is left empty
+        node_store(node_store&& other) noexcept
+            : chunks(std::move(other.chunks)), count(std::exchange(other.count, 0)) {}
+
+        node_store& operator=(node_store&& other) noexcept {
+            if (this != &other) {
+                this->clear();
+                this->chunks = std::move(other.chunks);
+                this->count = std::exchange(other.count, 0);
+            }
+            return *this;
+        }
+
+        ~node_store() {
+            this->clear();
+        }
+
+        void clear() {
+            if constexpr (!std::is_trivially_destructible_v<Node>) {
+                for (uint32_t i = 0; i < this->count; i++) {
+                    this->get(i)->~Node();
+                }
+            }
+            this->chunks.clear();
+            this->count = 0;
+        }
+
+        template <typename... Args>
+        handle create(Args&&... args) {
+            assert(this->count < max_handle);
+            if ((this->count & chunk_mask) == 0) {
+                void* chunk = ::operator new(sizeof(Node) << chunk_bits, std::align_val_t(alignof(Node)));
+                this->chunks.emplace_back(static_cast<Node*>(chunk));
+            }
+
+            handle node = this->count;
+            ::new (static_cast<void*>(this->chunks.back().get() + (node & chunk_mask))) Node(std::forward<Args>(args)...);
+            this->count++;
+            return node;
+        }
+
+        // nodes are only released with the whole pool
+        void destroy(handle) {}
+
+        Node* get(handle node) const {
+            return this->chunks[node >> chunk_bits].get() + (node & chunk_mask);
+        }
+    };
+}
@@ -0,0 +1,268 @@
+#pragma once
+#include <functional>
+#include <utility>
+#if __cplusplus >= 202002L
+#include <compare>
+#include <concepts>
+#endif
+#include "node_storage.hpp"
+#include "simd_rank.hpp"
+
+namespace detail {
+    // a transparent Compare (such as std::less<>) compares the keys directly with probes of other types
+    template <typename Compare, typename = void>
+    inline constexpr bool is_transparent = false;
+
+    template <typename Compare>
+    inline constexpr bool is_transparent<Compare, std::void_t<typename Compare::is_transparent>> = true;
+
+    // type a lookup key is compared as: the key itself with a transparent Compare, K otherwise
+    template <typename Compare, typename K, typename Key>
+    using probe_t = std::conditional_t<is_transparent<Compare>, Key, K>;
+
+    // whether a node key counts towards the rank of key: it is smaller than key (Inclusive = false)
+    // or not greater than key (Inclusive = true)
+    template <bool Inclusive, typename Compare, typename T, typename Key>
+    bool ranks_before(const Compare& compare, const T& element, const Key& key) {
+        return Inclusive ? !compare(key, element) : compare(element, key);
+    }
+
+    // Compare is the plain operator< of the keys
+    template <typename Compare, typename T>
+    inline constexpr bool is_plain_less = std::is_same_v<Compare, std::less<T>> || std::is_same_v<Compare, std::less<>>;
+
+    // the vector kernel applies to arithmetic keys stored inline, probed with the key type itself
+    // and ordered by the built-in operator<
+    template <typename Slot, typename Key, typename Compare>
+    inline constexpr bool uses_simd_rank = has_simd_rank<Key> && std::is_same_v<typename Slot::type, Key> && is_plain_less<Compare, Key>;
+
+    // Compare is operator< and the types also provide operator<=> (C++20), so one call orders two keys
+#if __cplusplus >= 202002L
+    template <typename Compare, typename T, typename Key>
+    inline constexpr bool is_three_way = is_plain_less<Compare, T> && std::three_way_comparable_with<T, Key>;
+#else
+    template <typename Compare, typename T, typename Key>
+    inline constexpr bool is_three_way = false;
+#endif
+
+    // negative, zero or positive as a node key sorts before, with or after key: a single operator<=>
+    // when is_three_way, otherwise up to two calls of compare
+    template <typename Compare, typename T, typename Key>
+    int order(const Compare& compare, const T& element, const Key& key) {
+#if __cplusplus >= 202002L
+        if constexpr (is_three_way<Compare, T, Key>) {
+            auto result = element <=> key;
+            return result < 0 ? -1 : result > 0 ? 1 : 0;
+        }
+#endif
+        return compare(element, key) ? -1 : compare(key, element) ? 1 : 0;
+    }
+
+    // locate() from a policy's lower rank, with one more comparison to test the key at the rank;
+    // for policies whose comparisons are cheap (arithmetic keys, fixed-trip loops)
+    template <typename Policy, typename Slot, typename Array, typename Key, typename Compare>
+    std::pair<int, bool> locate_by_rank(const Array& keys, const Key& key, const Compare& compare) {
+        int i = Policy::template rank<false, Slot>(keys, key, compare);
+        return {i, i < keys.size() && !compare(key, Slot::get(keys[i]))};
+    }
+}
+
+// search policies for the key search inside a node, given as the Search parameter of a tree.
+// Each one provides rank<Inclusive, Slot>(keys, key, compare): the number of keys in the node that
+// are smaller than key (Inclusive = false) or not greater than key (Inclusive = true), and
+// locate<Slot>(keys, key, compare): the lower rank together with whether the key there equals key
+
+// scan from the first key; fixed-capacity nodes of trivial keys count over every slot
+// with a fixed trip count instead, so the loop can be unrolled and vectorized
+struct LinearSearch {
+    template <bool Inclusive, typename Slot, typename Array, typename Key, typename Compare>
+    static int rank(const Array& keys, const Key& key, const Compare& compare) {
+        int n = static_cast<int>(keys.size());
+
+        if constexpr (detail::is_padded_array<Array>) {
+            int i = 0;
+            for (int j = 0; j < Array::capacity; j++) {
+                i += (j < n) & detail::ranks_before<Inclusive>(compare, keys[j], key);
+            }
+            return i;
+        } else {
+            int i = 0;
+            while (i < n && detail::ranks_before<Inclusive>(compare, Slot::get(keys[i]), key)) {
+                i++;
+            }
+            return i;
+        }
+    }
+
+    // the scan stops at the first key that is not smaller, and the same comparison tells whether it is equal
+    template <typename Slot, typename Array, typename Key, typename Compare>
+    static std::pair<int, bool> locate(const Array& keys, const Key& key, const Compare& compare) {
+        if constexpr (detail::is_padded_array<Array>) {
+            return detail::locate_by_rank<LinearSearch, Slot>(keys, key, compare);
+        } else {
+            int n = static_cast<int>(keys.size());
+            for (int i = 0; i < n; i++) {
+                int order = detail::order(compare, Slot::get(keys[i]), key);
+                if (order >= 0) {
+                    return {i, order == 0};
+                }
+            }
+            return {n, false};
+        }
+    }
+};
+
+// binary search that halves the range with a conditional move instead of a branch,
+// so every search in a node of n keys takes the same log2(n) steps
+struct BinarySearch {
+    template <bool Inclusive, typename Slot, typename Array, typename Key, typename Compare>
+    static int rank(const Array& keys, const Key& key, const Compare& compare) {
+        int n = static_cast<int>(keys.size());
+        if (n == 0) {
+            return 0;
+        }
+
+        auto base = keys.data();
+        while (n > 1) {
+            int half = n / 2;
+            base = detail::ranks_before<Inclusive>(compare, Slot::get(base[half]), key) ? base + half : base;
+            n -= half;
+        }
+
+        return static_cast<int>(base - keys.data()) + detail::ranks_before<Inclusive>(compare, Slot::get(*base), key);
+    }
+
+    // with operator<=> every step compares three-way: when one of them meets an equal key, the first
+    // key not smaller than key is equal as well, and only when none did is that key compared once more.
+    // Without it a step would take two calls of compare, and arithmetic keys compare in one instruction
+    // either way, so those take the rank followed by a single equality test
+    template <typename Slot, typename Array, typename Key, typename Compare>
+    static std::pair<int, bool> locate(const Array& keys, const Key& key, const Compare& compare) {
+        using element = std::decay_t<decltype(Slot::get(keys[0]))>;
+
+        if constexpr (detail::is_three_way<Compare, element, Key> && !std::is_arithmetic_v<element>) {
+            int n = static_cast<int>(keys.size());
+            if (n == 0) {
+                return {0, false};
+            }
+
+            auto base = keys.data();
+            bool equal = false;
+            while (n > 1) {
+                int half = n / 2;
+                int order = detail::order(compare, Slot::get(base[half]), key);
+                equal |= order == 0;
+                base = order < 0 ? base + half : base;
+                n -= half;
+            }
+
+            int order = detail::order(compare, Slot::get(*base), key);
+            equal |= order == 0;
+            int i = static_cast<int>(base - keys.data()) + (order < 0);
+            if (!equal && i < keys.size()) {
+                equal = !compare(key, Slot::get(keys[i]));
+            }
+            return {i, equal};
+        } else {
+            return detail::locate_by_rank<BinarySearch, Slot>(keys, key, compare);
+        }
+    }
+};
+
+// compare a vector of keys per instruction (see simd_rank.hpp); key types without a
+// vector kernel for the target, boxed keys and custom orders fall back to the linear scan
+struct SimdSearch {
+    template <bool Inclusive, typename Slot, typename Array, typename Key, typename Compare>
+    static int rank(const Array& keys, const Key& key, const Compare& compare) {
+        if constexpr (detail::uses_simd_rank<Slot, Key, Compare>) {
+            return detail::simd_rank<Inclusive>(keys.data(), static_cast<int>(keys.size()), key);
+        } else {
+            return LinearSearch::rank<Inclusive, Slot>(keys, key, compare);
+        }
+    }
+
+    template <typename Slot, typename Array, typename Key, typename Compare>
+    static std::pair<int, bool> locate(const Array& keys, const Key& key, const Compare& compare) {
+        if constexpr (detail::uses_simd_rank<Slot, Key, Compare>) {
+            return detail::locate_by_rank<SimdSearch, Slot>(keys, key, compare);
+        } else {
+            return LinearSearch::locate<Slot>(keys, key, compare);
+        }
+    }
+};
+
+// default policy, picked from benchmark/search_policy.cpp: the fixed-trip linear loop in padded
+// nodes of up to fixed_trip_limit keys, which the compiler vectorizes without a branch per vector;
+// otherwise the vector kernel for arithmetic keys that have one, the branchless binary search for
+// other arithmetic keys, and for any other key type a linear scan up to binary_limit keys (binary
+// search would chain the cache misses of dereferencing each probed key) and binary search beyond
+struct AdaptiveSearch {
+    static constexpr int fixed_trip_limit = 64;
+    static constexpr int binary_limit = 128;
+
+    template <bool Inclusive, typename Slot, typename Array, typename Key, typename Compare>
+    static int rank(const Array& keys, const Key& key, const Compare& compare) {
+        constexpr int capacity = detail::padded_capacity<Array>;
+
+        if constexpr (capacity > 0 && capacity <= fixed_trip_limit) {
+            return LinearSearch::rank<Inclusive, Slot>(keys, key, compare);
+        } else if constexpr (detail::uses_simd_rank<Slot, Key, Compare>) {
+            return SimdSearch::rank<Inclusive, Slot>(keys, key, compare);
+        } else if constexpr (std::is_arithmetic_v<typename Slot::type>) {
+            return BinarySearch::rank<Inclusive, Slot>(keys, key, compare);
+        } else if (keys.size() > binary_limit) {
+            return BinarySearch::rank<Inclusive, Slot>(keys, key, compare);
+        } else {
+            return LinearSearch::rank<Inclusive, Slot>(keys, key, compare);
+        }
+    }
+
+    template <typename Slot, typename Array, typename Key, typename Compare>
+    static std::pair<int, bool> locate(const Array& keys, const Key& key, const Compare& compare) {
+        constexpr int capacity = detail::padded_capacity<Array>;
+
+        if constexpr (capacity > 0 && capacity <= fixed_trip_limit) {
+            return LinearSearch::locate<Slot>(keys, key, compare);
+        } else if constexpr (detail::uses_simd_rank<Slot, Key, Compare>) {
+            return SimdSearch::locate<Slot>(keys, key, compare);
+        } else if constexpr (std::is_arithmetic_v<typename Slot::type>) {
+            return BinarySearch::locate<Slot>(keys, key, compare);
+        } else if (keys.size() > binary_limit) {
+            return BinarySearch::locate<Slot>(keys, key, compare);
+        } else {
+            return LinearSearch::locate<Slot>(keys, key, compare);
+        }
+    }
+};
+
+namespace detail {
+    // index of the first key not smaller than key
+    template <typename Search, typename Slot, typename Array, typename Key, typename Compare>
+    int lower_rank(const Array& keys, const Key& key, const Compare& compare) {
+        return Search::template rank<false, Slot>(keys, key, compare);
+    }
+
+    // index of the first key greater than key
+    template <typename Search, typename Slot, typename Array, typename Key, typename Compare>
+    int upper_rank(const Array& keys, const Key& key, const Compare& compare) {
+        return Search::template rank<true, Slot>(keys, key, compare);
+    }
+
+    // index of the first key not smaller than key, and whether that key is equal to key
+    template <typename Search, typename Slot, typename Array, typename Key, typename Compare>
+    std::pair<int, bool> locate(const Array& keys, const Key& key, const Compare& compare) {
+        return Search::template locate<Slot>(keys, key, compare);
+    }
+
+    // pass an entry of a range scan to visit(key, value); false when visit asks to stop the scan,
+    // which a visitor returning void never does
+    template <typename Visitor, typename K, typename V>
+    bool visit_entry(Visitor& visit, const K& key, const V& value) {
+        if constexpr (std::is_void_v<std::invoke_result_t<Visitor&, const K&, const V&>>) {
+            visit(key, value);
+            return true;
+        } else {
+            return static_cast<bool>(visit(key, value));
+        }
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace detail {
+    // keys and values are stored inline in the node when they can be shifted around cheaply,
+    // otherwise (non-movable or throwing move) they are boxed behind a unique_ptr
+    template <typename T>
+    inline constexpr bool is_inline_storable = std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>;
+
+    template <typename T, bool Inline = is_inline_storable<T>>
+    struct slot {
+        using type = T;
+
+        static type make(T&& value) { return std::move(value); }
+        static T& get(type& s) { return s; }
+        static const T& get(const type& s) { return s; }
+    };
+
+    template <typename T>
+    struct slot<T, false> {
+        using type = std::unique_ptr<T>;
+
+        static type make(T&& value) {
+            if constexpr (std::is_move_constructible_v<T>) {
+                return std::make_unique<T>(std::move(value));
+            } else {
+                return std::make_unique<T>(std::as_const(value));
+            }
+        }
+        static T& get(type& s) { return *s; }
+        static const T& get(const type& s) { return *s; }
+    };
+
+    // backing store of a fixed_vector; trivial types get a value-initialized array so that
+    // every slot (also the ones past size()) can be read by fixed-trip search loops, and
+    // the store stays trivially destructible
+    template <typename T, int N, bool Padded = std::is_trivial_v<T>>
+    struct fixed_storage {
+        T items[N]{};
+        int count = 0;
+
+        T* data() { return this->items; }
+        const T* data() const { return this->items; }
+    };
+
+    template <typename T, int N>
+    struct fixed_storage<T, N, false> {
+        alignas(T) unsigned char bytes[N * sizeof(T)];
+        int count = 0;
+
+        fixed_storage() = default;
+        fixed_storage(const fixed_storage&) = delete;
+        fixed_storage& operator=(const fixed_storage&) = delete;
+        ~fixed_storage() { std::destroy_n(this->data(), this->count); }
+
+        T* data() { return std::launder(reinterpret_cast<T*>(this->bytes)); }
+        const T* data() const { return std::launder(reinterpret_cast<const T*>(this->bytes)); }
+    };
+
+    // vector-like array with inline capacity N, so a node is a single allocation
+    template <typename T, int N>
+    class fixed_vector {
+        fixed_storage<T, N> storage;
+
+    public:
+        static constexpr int capacity = N;
+        static constexpr bool padded = std::is_trivial_v<T>;
+
+        fixed_vector() = default;
+        fixed_vector(const fixed_vector&) = delete;
+        fixed_vector& operator=(const fixed_vector&) = delete;
+
+        int size() const { return this->storage.count; }
+        bool empty() const { return this->storage.count == 0; }
+        T* data() { return this->storage.data(); }
+        const T* data() const { return this->storage.data(); }
+        T* begin() { return this->data(); }
+        T* end() { return this->data() + this->storage.count; }
+        const T* begin() const { return this->data(); }
+        const T* end() const { return this->data() + this->storage.count; }
+        T& operator[](int i) { return this->data()[i]; }
+        const T& operator[](int i) const { return this->data()[i]; }
+        T& back() { return this->data()[this->storage.count - 1]; }
+
+        void push_back(T value) {
+            ::new (static_cast<void*>(this->end())) T(std::move(value));
+            this->storage.count++;
+        }
+
+        void insert(T* position, T value) {
+            if (position == this->end()) {
+                this->push_back(std::move(value));
+                return;
+            }
+            // shift [position, end) one slot to the right
+            ::new (static_cast<void*>(this->end())) T(std::move(this->back()));
+            std::move_backward(position, this->end() - 1, this->end());
+            *position = std::move(value);
+            this->storage.count++;
+        }
+
+        void erase(T* first, T* last) {
+            T* new_end = std::move(last, this->end(), first);
+            std::destroy(new_end, this->end());
+            this->storage.count = static_cast<int>(new_end - this->data());
+        }
+    };
+
+    // request the cache lines of [address, address + bytes) ahead of a search
+    inline void prefetch(const void* address, size_t bytes) {
+        const char* first = static_cast<const char*>(address);
+        for (size_t offset = 0; offset < bytes; offset += 64) {
+            __builtin_prefetch(first + offset);
+        }
+    }
+
+    // node arrays are heap vectors when the degree is only known at runtime (N == 0); they use
+    // std::allocator whatever the Allocator of the tree
+    template <typename T, int N>
+    using node_array = std::conditional_t<N == 0, std::vector<T>, fixed_vector<T, N>>;
+
+    template <typename Array>
+    inline constexpr bool is_padded_array = false;
+
+    template <typename T, int N>
+    inline constexpr bool is_padded_array<fixed_vector<T, N>> = fixed_vector<T, N>::padded;
+
+    // number of slots that can be read in a padded array, 0 for any other array
+    template <typename Array>
+    inline constexpr int padded_capacity = 0;
+
+    template <typename T, int N>
+    inline constexpr int padded_capacity<fixed_vector<T, N>> = fixed_vector<T, N>::padded ? N : 0;
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+#if !defined(TREES_NO_SIMD) && (defined(__AVX2__) || defined(__SSE2__))
+#define TREES_SIMD_RANK 1
+#include <immintrin.h>
+#endif
+
+namespace detail {
+    // compares one vector of keys against a broadcast probe and returns a bit mask of the lanes whose
+    // key is smaller than the probe (Inclusive = false) or not greater than it (Inclusive = true);
+    // only specialized for the key types the target instruction set can compare
+    template <typename K, bool Inclusive>
+    struct simd_kernel {
+        static constexpr int lanes = 0;
+    };
+
+#if defined(TREES_SIMD_RANK)
+#if defined(__AVX2__)
+    template <bool Inclusive>
+    struct simd_kernel<double, Inclusive> {
+        static constexpr int lanes = 4;
+        __m256d probe;
+
+        explicit simd_kernel(double key) : probe(_mm256_set1_pd(key)) {}
+
+        int below(const double* keys) const {
+            __m256d block = _mm256_loadu_pd(keys);
+            return _mm256_movemask_pd(_mm256_cmp_pd(block, this->probe, Inclusive ? _CMP_LE_OQ : _CMP_LT_OQ));
+        }
+    };
+
+    template <bool Inclusive>
+    struct simd_kernel<float, Inclusive> {
+        static constexpr int lanes = 8;
+        __m256 probe;
+
+        explicit simd_kernel(float key) : probe(_mm256_set1_ps(key)) {}
+
+        int below(const float* keys) const {
+            __m256 block = _mm256_loadu_ps(keys);
+            return _mm256_movemask_ps(_mm256_cmp_ps(block, this->probe, Inclusive ? _CMP_LE_OQ : _CMP_LT_OQ));
+        }
+    };
+
+    // integers only have a greater-than compare: k < key is key > k, and k <= key is !(k > key)
+    template <bool Inclusive>
+    struct simd_kernel<int32_t, Inclusive> {
+        static constexpr int lanes = 8;
+        __m256i probe;
+
+        explicit simd_kernel(int32_t key) : probe(_mm256_set1_epi32(key)) {}
+
+        int below(const int32_t* keys) const {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+            __m256i cmp = Inclusive ? _mm256_cmpgt_epi32(block, this->probe) : _mm256_cmpgt_epi32(this->probe, block);
+            int mask = _mm256_movemask_ps(_mm256_castsi256_ps(cmp));
+            return Inclusive ? ~mask & 0xFF : mask;
+        }
+    };
+
+    template <bool Inclusive>
+    struct simd_kernel<int64_t, Inclusive> {
+        static constexpr int lanes = 4;
+        __m256i probe;
+
+        explicit simd_kernel(int64_t key) : probe(_mm256_set1_epi64x(key)) {}
+
+        int below(const int64_t* keys) const {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+            __m256i cmp = Inclusive ? _mm256_cmpgt_epi64(block, this->probe) : _mm256_cmpgt_epi64(this->probe, block);
+            int mask = _mm256_movemask_pd(_mm256_castsi256_pd(cmp));
+            return Inclusive ? ~mask & 0xF : mask;
+        }
+    };
+#else
+    template <bool Inclusive>
+    struct simd_kernel<double, Inclusive> {
+        static constexpr int lanes = 2;
+        __m128d probe;
+
+        explicit simd_kernel(double key) : probe(_mm_set1_pd(key)) {}
+
+        int below(const double* keys) const {
+            __m128d block = _mm_loadu_pd(keys);
+            return _mm_movemask_pd(Inclusive ? _mm_cmple_pd(block, this->probe) : _mm_cmplt_pd(block, this->probe));
+        }
+    };
+
+    template <bool Inclusive>
+    struct simd_kernel<float, Inclusive> {
+        static constexpr int lanes = 4;
+        __m128 probe;
+
+        explicit simd_kernel(float key) : probe(_mm_set1_ps(key)) {}
+
+        int below(const float* keys) const {
+            __m128 block = _mm_loadu_ps(keys);
+            return _mm_movemask_ps(Inclusive ? _mm_cmple_ps(block, this->probe) : _mm_cmplt_ps(block, this->probe));
+        }
+    };
+
+    // integers only have a greater-than compare: k < key is key > k, and k <= key is !(k > key)
+    template <bool Inclusive>
+    struct simd_kernel<int32_t, Inclusive> {
+        static constexpr int lanes = 4;
+        __m128i probe;
+
+        explicit simd_kernel(int32_t key) : probe(_mm_set1_epi32(key)) {}
+
+        int below(const int32_t* keys) const {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys));
+            __m128i cmp = Inclusive ? _mm_cmpgt_epi32(block, this->probe) : _mm_cmpgt_epi32(this->probe, block);
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(cmp));
+            return Inclusive ? ~mask & 0xF : mask;
+        }
+    };
+
+#if defined(__SSE4_2__)
+    template <bool Inclusive>
+    struct simd_kernel<int64_t, Inclusive> {
+        static constexpr int lanes = 2;
+        __m128i probe;
+
+        explicit simd_kernel(int64_t key) : probe(_mm_set1_epi64x(key)) {}
+
+        int below(const int64_t* keys) const {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys));
+            __m128i cmp = Inclusive ? _mm_cmpgt_epi64(block, this->probe) : _mm_cmpgt_epi64(this->probe, block);
+            int mask = _mm_movemask_pd(_mm_castsi128_pd(cmp));
+            return Inclusive ? ~mask & 0x3 : mask;
+        }
+    };
+#endif
+#endif
+#endif
+
+    // key types with a vectorized rank kernel for the instruction set the headers are compiled for;
+    // build with -DTREES_NO_SIMD to force the scalar loops
+    template <typename K>
+    inline constexpr bool has_simd_rank = simd_kernel<K, false>::lanes > 0;
+
+    // length of the run of set bits at the bottom of mask; the lanes below a probe form such a run
+    // since the keys are sorted, and unlike popcount this needs no instruction beyond the baseline
+    inline int prefix_length(int mask) {
+        return __builtin_ctz(mask + 1);
+    }
+
+    // number of the n sorted keys that are smaller than key (Inclusive = false) or not greater than
+    // key (Inclusive = true); compares a whole vector of keys at a time and stops at the first vector
+    // that is not entirely below key
+    template <bool Inclusive, typename K>
+    int simd_rank(const K* keys, int n, K key) {
+        using kernel = simd_kernel<K, Inclusive>;
+        constexpr int lanes = kernel::lanes;
+        constexpr int full = (1 << lanes) - 1;
+        const kernel probe(key);
+
+        int i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            int mask = probe.below(keys + i);
+            if (mask != full) {
+                return i + prefix_length(mask);
+            }
+        }
+
+        // scalar tail for the keys that do not fill a whole vector
+        while (i < n && (Inclusive ? keys[i] <= key : keys[i] < key)) {
+            i++;
+        }
+        return i;
+    }
+}